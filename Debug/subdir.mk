@@ -4,13 +4,70 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
-../gst-main.c 
+../autoplugger.c \
+../autotune.c \
+../bench.c \
+../gst-main.c \
+../gstxavidemux.c \
+../gstxoverlay.c \
+../gstxscale.c \
+../membudget.c \
+../plugin.c \
+../tunables.c \
+../xaudio.c \
+../xblend.c \
+../xconvert.c \
+../xloop.c \
+../xoverlay.c \
+../xplayer.c \
+../xposition.c \
+../xqos.c \
+../xrecovery.c \
+../xtrack.c 
 
 OBJS += \
-./gst-main.o 
+./autoplugger.o \
+./autotune.o \
+./bench.o \
+./gst-main.o \
+./gstxavidemux.o \
+./gstxoverlay.o \
+./gstxscale.o \
+./membudget.o \
+./plugin.o \
+./tunables.o \
+./xaudio.o \
+./xblend.o \
+./xconvert.o \
+./xloop.o \
+./xoverlay.o \
+./xplayer.o \
+./xposition.o \
+./xqos.o \
+./xrecovery.o \
+./xtrack.o 
 
 C_DEPS += \
-./gst-main.d 
+./autoplugger.d \
+./autotune.d \
+./bench.d \
+./gst-main.d \
+./gstxavidemux.d \
+./gstxoverlay.d \
+./gstxscale.d \
+./membudget.d \
+./plugin.d \
+./tunables.d \
+./xaudio.d \
+./xblend.d \
+./xconvert.d \
+./xloop.d \
+./xoverlay.d \
+./xplayer.d \
+./xposition.d \
+./xqos.d \
+./xrecovery.d \
+./xtrack.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
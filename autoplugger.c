@@ -7,8 +7,17 @@
 
 #include <gst/gst.h>
 
+#include "autoplugger.h"
+
+/*
+ * The factory list and the by-name cache are shared by all player instances,
+ * so the registry is only walked once per process. Everything else is kept
+ * per element, via the signal user data, so several pipelines can be plugged
+ * at the same time.
+ */
 static GList *factories;
-GstElement * pipeline;
+static GHashTable *factory_cache;
+static GStaticMutex factory_lock = G_STATIC_MUTEX_INIT;
 
 /*
  * This function is called by the registry loader. Its return value
@@ -49,13 +58,93 @@ static gint cb_compare_ranks(GstPluginFeature *f1, GstPluginFeature *f2)
   return gst_plugin_feature_get_rank (f2) - gst_plugin_feature_get_rank (f1);
 }
 
-static void init_factories(void)
+static gpointer init_factories(gpointer data)
 {
   /* first filter out the interesting element factories */
   factories = gst_registry_feature_filter(gst_registry_get_default(), (GstPluginFeatureFilter)cb_feature_filter, FALSE, NULL);
 
   /* sort them according to their ranks */
   factories = g_list_sort(factories, (GCompareFunc) cb_compare_ranks);
+
+  return factories;
+}
+
+const GList * autoplug_get_factories(void)
+{
+  static GOnce once = G_ONCE_INIT;
+
+  return g_once (&once, init_factories, NULL);
+}
+
+/*
+ * The highest ranked decoder whose always sink pad accepts caps. The list is
+ * sorted by rank already, so the first hit wins. klass narrows it down, e.g.
+ * "Audio" so that a demuxer or a video decoder is never picked.
+ */
+GstElementFactory * autoplug_find_decoder(const GstCaps *caps, const gchar *klass)
+{
+  const GList *item;
+
+  for (item = autoplug_get_factories (); item != NULL; item = item->next) {
+    GstElementFactory *factory = GST_ELEMENT_FACTORY (item->data);
+    const gchar *fklass = gst_element_factory_get_klass (factory);
+    const GList *pads;
+
+    if (g_strrstr (fklass, "Decoder") == NULL ||
+        (klass && g_strrstr (fklass, klass) == NULL))
+      continue;
+
+    for (pads = gst_element_factory_get_static_pad_templates (factory);
+         pads != NULL; pads = pads->next) {
+      GstStaticPadTemplate *templ = pads->data;
+      GstCaps *templcaps, *res;
+      gboolean found;
+
+      if (templ->direction != GST_PAD_SINK ||
+          templ->presence != GST_PAD_ALWAYS)
+        continue;
+
+      templcaps = gst_static_caps_get (&templ->static_caps);
+      res = gst_caps_intersect (caps, templcaps);
+      found = res && !gst_caps_is_empty (res);
+      gst_caps_unref (res);
+      gst_caps_unref (templcaps);
+      if (found)
+        return factory;
+      break;
+    }
+  }
+
+  return NULL;
+}
+
+/*
+ * gst_element_factory_make() looks the factory up in the registry every time,
+ * which takes the registry lock and walks its feature list. Keep the factories
+ * we have already found, they stay loaded for the life of the process anyway.
+ */
+GstElement * autoplug_factory_make(const gchar *factoryname, const gchar *name)
+{
+  GstElementFactory *factory;
+
+  g_static_mutex_lock (&factory_lock);
+  if (!factory_cache)
+    factory_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, gst_object_unref);
+
+  factory = g_hash_table_lookup (factory_cache, factoryname);
+  if (!factory) {
+    factory = gst_element_factory_find (factoryname);
+    if (factory)
+      g_hash_table_insert (factory_cache, g_strdup (factoryname), factory);
+  }
+  g_static_mutex_unlock (&factory_lock);
+
+  if (!factory) {
+    g_print ("No such element factory \"%s\"\n", factoryname);
+    return NULL;
+  }
+
+  return gst_element_factory_create (factory, name);
 }
 
 /*
@@ -68,32 +157,34 @@ static void init_factories(void)
  * to initiate autoplugging, which will continue with the above approach.
  */
 
-static void try_to_plug(GstPad *pad, const GstCaps *caps);
-
-static GstElement *audiosink;
+static void try_to_plug(GstPad *pad, const GstCaps *caps, GstElement *audiosink);
 
 static void cb_newpad(GstElement *element, GstPad *pad, gpointer data)
 {
   GstCaps *caps;
 
   caps = gst_pad_get_caps (pad);
-  try_to_plug (pad, caps);
+  try_to_plug (pad, caps, GST_ELEMENT (data));
   gst_caps_unref (caps);
 }
 
-static void close_link(GstPad *srcpad, GstElement *sinkelement, const gchar *padname, const GList *templlist)
+static void close_link(GstPad *srcpad, GstElement *sinkelement, const gchar *padname, const GList *templlist, GstElement *audiosink)
 {
   GstPad *pad;
+  GstElement *parent;
+  GstObject *bin;
   gboolean has_dynamic_pads = FALSE;
 
+  parent = gst_pad_get_parent_element (srcpad);
   g_print ("Plugging pad %s:%s to newly created %s:%s\n",
-	   gst_object_get_name (GST_OBJECT (gst_pad_get_parent (srcpad))),
-	   gst_pad_get_name (srcpad),
-	   gst_object_get_name (GST_OBJECT (sinkelement)), padname);
+	   GST_OBJECT_NAME (parent), GST_OBJECT_NAME (srcpad),
+	   GST_OBJECT_NAME (sinkelement), padname);
 
-  /* add the element to the pipeline and set correct state */
+  /* add the element next to the one we plug to and set correct state */
+  bin = gst_object_get_parent (GST_OBJECT (parent));
+  gst_object_unref (GST_OBJECT (parent));
   if (sinkelement != audiosink) {
-    gst_bin_add (GST_BIN (pipeline), sinkelement);
+    gst_bin_add (GST_BIN (bin), sinkelement);
     gst_element_set_state (sinkelement, GST_STATE_READY);
   }
   pad = gst_element_get_static_pad (sinkelement, padname);
@@ -102,6 +193,7 @@ static void close_link(GstPad *srcpad, GstElement *sinkelement, const gchar *pad
     gst_element_set_state (sinkelement, GST_STATE_PAUSED);
   }
   gst_object_unref (GST_OBJECT (pad));
+  gst_object_unref (bin);
 
   /* if we have static source pads, link those. If we have dynamic
    * source pads, listen for pad-added signals on the element */
@@ -120,7 +212,7 @@ static void close_link(GstPad *srcpad, GstElement *sinkelement, const gchar *pad
         GstCaps *caps = gst_pad_get_caps (pad);
 
         /* link */
-        try_to_plug (pad, caps);
+        try_to_plug (pad, caps, audiosink);
         gst_object_unref (GST_OBJECT (pad));
         gst_caps_unref (caps);
         break;
@@ -135,21 +227,24 @@ static void close_link(GstPad *srcpad, GstElement *sinkelement, const gchar *pad
 
   /* listen for newly created pads if this element supports that */
   if (has_dynamic_pads) {
-    g_signal_connect (sinkelement, "pad-added", G_CALLBACK (cb_newpad), NULL);
+    g_signal_connect (sinkelement, "pad-added", G_CALLBACK (cb_newpad), audiosink);
   }
 }
 
-static void try_to_plug(GstPad *pad, const GstCaps *caps)
+static void try_to_plug(GstPad *pad, const GstCaps *caps, GstElement *audiosink)
 {
   GstObject *parent = GST_OBJECT (GST_OBJECT_PARENT (pad));
   const gchar *mime;
   const GList *item;
-  GstCaps *res, *audiocaps;
+  GstCaps *res, *audiocaps, *templcaps;
+  GstPad *audiopad;
 
-  /* don't plug if we're already plugged - FIXME: memleak for pad */
-  if (GST_PAD_IS_LINKED (gst_element_get_static_pad (audiosink, "sink"))) {
+  /* don't plug if we're already plugged */
+  audiopad = gst_element_get_static_pad (audiosink, "sink");
+  if (GST_PAD_IS_LINKED (audiopad)) {
     g_print ("Omitting link for pad %s:%s because we're already linked\n",
 	     GST_OBJECT_NAME (parent), GST_OBJECT_NAME (pad));
+    gst_object_unref (audiopad);
     return;
   }
 
@@ -158,15 +253,17 @@ static void try_to_plug(GstPad *pad, const GstCaps *caps)
   if (g_strrstr (mime, "video")) {
     g_print ("Omitting link for pad %s:%s because mimetype %s is non-audio\n",
 	     GST_OBJECT_NAME (parent), GST_OBJECT_NAME (pad), mime);
+    gst_object_unref (audiopad);
     return;
   }
 
   /* can it link to the audiopad? */
-  audiocaps = gst_pad_get_caps (gst_element_get_static_pad (audiosink, "sink"));
+  audiocaps = gst_pad_get_caps (audiopad);
+  gst_object_unref (audiopad);
   res = gst_caps_intersect (caps, audiocaps);
   if (res && !gst_caps_is_empty (res)) {
     g_print ("Found pad to link to audiosink - plugging is now done\n");
-    close_link (pad, audiosink, "sink", NULL);
+    close_link (pad, audiosink, "sink", NULL, audiosink);
     gst_caps_unref (audiocaps);
     gst_caps_unref (res);
     return;
@@ -175,7 +272,7 @@ static void try_to_plug(GstPad *pad, const GstCaps *caps)
   gst_caps_unref (res);
 
   /* try to plug from our list */
-  for (item = factories; item != NULL; item = item->next) {
+  for (item = autoplug_get_factories (); item != NULL; item = item->next) {
     GstElementFactory *factory = GST_ELEMENT_FACTORY (item->data);
     const GList *pads;
 
@@ -190,8 +287,9 @@ static void try_to_plug(GstPad *pad, const GstCaps *caps)
       }
 
       /* can it link? */
-      res = gst_caps_intersect (caps,
-          gst_static_caps_get (&templ->static_caps));
+      templcaps = gst_static_caps_get (&templ->static_caps);
+      res = gst_caps_intersect (caps, templcaps);
+      gst_caps_unref (templcaps);
       if (res && !gst_caps_is_empty (res)) {
         GstElement *element;
         gchar *name_template = g_strdup (templ->name_template);
@@ -200,7 +298,7 @@ static void try_to_plug(GstPad *pad, const GstCaps *caps)
         gst_caps_unref (res);
         element = gst_element_factory_create (factory, NULL);
         close_link (pad, element, name_template,
-		    gst_element_factory_get_static_pad_templates (factory));
+		    gst_element_factory_get_static_pad_templates (factory), audiosink);
         g_free (name_template);
         return;
       }
@@ -228,6 +326,11 @@ static void cb_typefound(GstElement *typefind, guint probability, GstCaps *caps,
 
   /* actually plug now */
   pad = gst_element_get_static_pad (typefind, "src");
-  try_to_plug (pad, caps);
+  try_to_plug (pad, caps, GST_ELEMENT (data));
   gst_object_unref (GST_OBJECT (pad));
 }
+
+void autoplug_typefind(GstElement *typefind, GstElement *audiosink)
+{
+  g_signal_connect (typefind, "have-type", G_CALLBACK (cb_typefound), audiosink);
+}
@@ -0,0 +1,22 @@
+/*
+ * autoplugger.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#ifndef AUTOPLUGGER_H_
+#define AUTOPLUGGER_H_
+
+#include <gst/gst.h>
+
+/* decoder/demuxer/parser factories by rank, built once per process */
+const GList * autoplug_get_factories(void);
+/* best ranked decoder for caps, klass is matched against the factory class */
+GstElementFactory * autoplug_find_decoder(const GstCaps * caps, const gchar * klass);
+/* gst_element_factory_make() through the shared factory cache */
+GstElement * autoplug_factory_make(const gchar * factoryname, const gchar * name);
+/* plug decoders from typefind's src pad up to the audio sink */
+void autoplug_typefind(GstElement * typefind, GstElement * audiosink);
+
+#endif /* AUTOPLUGGER_H_ */
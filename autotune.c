@@ -0,0 +1,349 @@
+/*
+ * autotune.c - pipeline tunables search
+ *
+ * Plays the clip headless (fakesink, no audio) once with the current
+ * tunables and then once for every point of a small grid: video queue
+ * depth, the size the demuxer reads in and max-lateness, with the queue byte
+ * and time limits kept as they are. The best point is then tried once more
+ * without those limits. The read size is the xavidemux window when the
+ * demuxer has one, the filesrc block size only matters to push mode
+ * demuxers like avidemux. Every run is measured for startup time (load to
+ * PLAYING), the share of frames shown in real time, frames dropped or late
+ * and the RSS growth. The best run wins in that order of importance and is
+ * written as the profile the player loads at startup. A run only replaces
+ * the best one if it is clearly better, so on ties the current settings
+ * stay.
+ *
+ * Sink sync stays at the platform value. A fakesink that does not sync
+ * never waits and is never late, so it would always look best here and
+ * break timed playback on the real display sink.
+ *
+ * The demuxer, the queues and the decoder of the target are what is
+ * measured, so this has to run on the board itself. The display is not,
+ * fakesink takes its place.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <gst/gst.h>
+#include <glib.h>
+
+#include "autotune.h"
+#include "autoplugger.h"
+#include "membudget.h"
+
+#define AUTOTUNE_STARTUP_TIMEOUT	10	/* s */
+#define AUTOTUNE_RSS_INTERVAL		100	/* ms */
+
+static const guint grid_queue_buffers[] = { 1, 2, 4, 8 };
+static const guint grid_blocksize[] = { 64 * 1024, 256 * 1024, 1600000 };
+static const guint grid_window[] = { 64 * 1024, 256 * 1024, 1024 * 1024 };
+static const gint64 grid_lateness[] = { 5 * GST_MSECOND, 20 * GST_MSECOND, 40 * GST_MSECOND, -1 };
+
+typedef struct {
+	gboolean ok;
+	gdouble startup;		/* ms */
+	gdouble realtime;		/* frames shown / frames due, at most 1 */
+	guint64 frames;
+	guint64 lost;			/* dropped before the decoder or late in the sink */
+	guint64 rss;			/* growth over the idle player */
+} xTuneResult;
+
+typedef struct {
+	GMainLoop * loop;
+	volatile gint event;	/* last event + 1, 0 for none */
+	gboolean timed_out;
+	guint64 rss_base;
+	guint64 rss_peak;
+} xTuneRun;
+
+static gboolean quit_idle(gpointer data)
+{
+	g_main_loop_quit((GMainLoop *) data);
+	return FALSE;
+}
+
+/* runs in the player thread, the idle also covers an event seen before the loop runs */
+static void tune_event(xPlayer * player, xPlayerEvent event, const gchar * detail, gpointer data)
+{
+	xTuneRun * run = (xTuneRun *) data;
+
+	switch(event) {
+	case XPLAYER_EVENT_PLAYING:
+	case XPLAYER_EVENT_EOS:
+	case XPLAYER_EVENT_ERROR:
+		g_atomic_int_set(&run->event, event + 1);
+		g_idle_add(quit_idle, run->loop);
+		break;
+	default:
+		break;
+	}
+}
+
+static gboolean run_timeout(gpointer data)
+{
+	xTuneRun * run = (xTuneRun *) data;
+
+	run->timed_out = TRUE;
+	g_main_loop_quit(run->loop);
+
+	return FALSE;
+}
+
+static gboolean sample_rss(gpointer data)
+{
+	xTuneRun * run = (xTuneRun *) data;
+	guint64 rss = mem_budget_read_rss();
+
+	if(rss > run->rss_peak)
+		run->rss_peak = rss;
+
+	return TRUE;
+}
+
+static gboolean run_ended(xTuneRun * run)
+{
+	gint event = g_atomic_int_get(&run->event);
+
+	return event == XPLAYER_EVENT_EOS + 1 || event == XPLAYER_EVENT_ERROR + 1;
+}
+
+static void measure(const gchar * filename, const xPlayerConfig * config, gint seconds, xTuneResult * res)
+{
+	xTuneRun run = { 0 };
+	xPlayer * player;
+	xQosStats qos;
+	GTimer * timer;
+	gdouble played, due;
+	guint timeout_id, rss_id;
+
+	memset(res, 0, sizeof(*res));
+
+	run.loop = g_main_loop_new(NULL, FALSE);
+	player = xplayer_new(config, tune_event, &run);
+	if(!player) {
+		g_main_loop_unref(run.loop);
+		return;
+	}
+	run.rss_base = run.rss_peak = mem_budget_read_rss();
+
+	timer = g_timer_new();
+	if(!xplayer_load(player, filename) || !xplayer_play(player))
+		goto out;
+
+	timeout_id = g_timeout_add(AUTOTUNE_STARTUP_TIMEOUT * 1000, run_timeout, &run);
+	while(!run.timed_out && !run_ended(&run) && g_atomic_int_get(&run.event) != XPLAYER_EVENT_PLAYING + 1)
+		g_main_loop_run(run.loop);
+	if(!run.timed_out)
+		g_source_remove(timeout_id);
+	if(g_atomic_int_get(&run.event) != XPLAYER_EVENT_PLAYING + 1)
+		goto out;
+	res->startup = g_timer_elapsed(timer, NULL) * 1000;
+
+	g_timer_start(timer);
+	run.timed_out = FALSE;
+	timeout_id = g_timeout_add(seconds * 1000, run_timeout, &run);
+	rss_id = g_timeout_add(AUTOTUNE_RSS_INTERVAL, sample_rss, &run);
+	/* PLAYING comes again after a recovery, only the end or the timeout stop the run */
+	while(!run.timed_out && !run_ended(&run))
+		g_main_loop_run(run.loop);
+	if(!run.timed_out)
+		g_source_remove(timeout_id);
+	g_source_remove(rss_id);
+	played = g_timer_elapsed(timer, NULL);
+
+	if(g_atomic_int_get(&run.event) == XPLAYER_EVENT_ERROR + 1 || !xplayer_get_qos(player, &qos) || !qos.frames)
+		goto out;
+
+	res->frames = qos.frames - MIN(qos.dropped, qos.frames);
+	res->lost = qos.dropped + qos.late;
+	due = played * GST_SECOND / qos.frame_duration;
+	res->realtime = due > 0 ? MIN(1.0, (res->frames - MIN(qos.late, res->frames)) / due) : 0;
+	res->rss = run.rss_peak - run.rss_base;
+	res->ok = TRUE;
+
+out:
+	g_timer_destroy(timer);
+	xplayer_destroy(player);
+	/* idles from late events must not stop the next run */
+	while(g_main_context_iteration(NULL, FALSE))
+		;
+	g_main_loop_unref(run.loop);
+}
+
+static gdouble lost_ratio(const xTuneResult * res)
+{
+	return (gdouble) res->lost / (res->frames + res->lost);
+}
+
+/* fewer frames lost, then closer to real time, then faster startup, then less memory */
+static gboolean better(const xTuneResult * a, const xTuneResult * b)
+{
+	gdouble la, lb;
+
+	if(!a->ok)
+		return FALSE;
+	if(!b->ok)
+		return TRUE;
+
+	la = lost_ratio(a);
+	lb = lost_ratio(b);
+	if(la < lb - 0.005 || la > lb + 0.005)
+		return la < lb;
+	if(a->realtime < b->realtime - 0.01 || a->realtime > b->realtime + 0.01)
+		return a->realtime > b->realtime;
+	if(a->startup < b->startup - 20 || a->startup > b->startup + 20)
+		return a->startup < b->startup;
+
+	return a->rss + 256 * 1024 < b->rss;
+}
+
+static void print_result(const gchar * what, const xTunables * tune, const xTuneResult * res)
+{
+	g_print("%-8s queue %u/%u/%" G_GUINT64_FORMAT " block %7u window %7u sync %d lateness %5" G_GINT64_FORMAT " ms: ",
+			what, tune->video_queue_buffers, tune->video_queue_bytes, tune->video_queue_time,
+			tune->source_blocksize, tune->demuxer_window, tune->sink_sync,
+			tune->max_lateness < 0 ? (gint64) -1 : tune->max_lateness / (gint64) GST_MSECOND);
+	if(!res->ok) {
+		g_print("failed\n");
+		return;
+	}
+	g_print("startup %6.1f ms realtime %5.1f%% lost %" G_GUINT64_FORMAT "/%" G_GUINT64_FORMAT " rss +%" G_GUINT64_FORMAT " KB\n",
+			res->startup, res->realtime * 100, res->lost, res->frames + res->lost, res->rss / 1024);
+}
+
+static void result_to_keyfile(GKeyFile * kf, const gchar * prefix, const xTuneResult * res)
+{
+	gchar * key;
+
+	key = g_strconcat(prefix, "-startup-ms", NULL);
+	g_key_file_set_double(kf, "autotune", key, res->startup);
+	g_free(key);
+	key = g_strconcat(prefix, "-realtime", NULL);
+	g_key_file_set_double(kf, "autotune", key, res->realtime);
+	g_free(key);
+	key = g_strconcat(prefix, "-lost-ratio", NULL);
+	g_key_file_set_double(kf, "autotune", key, lost_ratio(res));
+	g_free(key);
+	key = g_strconcat(prefix, "-rss-kb", NULL);
+	g_key_file_set_integer(kf, "autotune", key, res->rss / 1024);
+	g_free(key);
+}
+
+static void try_tunables(const gchar * filename, xPlayerConfig * config, gint seconds,
+		xTunables * best, xTuneResult * best_res)
+{
+	xTuneResult res;
+
+	measure(filename, config, seconds, &res);
+	print_result("grid", &config->tune, &res);
+	if(better(&res, best_res)) {
+		*best = config->tune;
+		*best_res = res;
+	}
+}
+
+/* xavidemux pulls windows of its own, the filesrc blocksize does not apply to it */
+static gboolean demuxer_has_window(const gchar * demuxer)
+{
+	GstElement * Demuxer = autoplug_factory_make(demuxer, NULL);
+	gboolean ret;
+
+	if(!Demuxer)
+		return FALSE;
+	ret = g_object_class_find_property(G_OBJECT_GET_CLASS(Demuxer), "window-size") != NULL;
+	gst_object_unref(GST_OBJECT(Demuxer));
+
+	return ret;
+}
+
+gboolean autotune_run(const gchar * filename, const xPlayerConfig * base, const gchar * profile, gint seconds)
+{
+	xPlayerConfig config = *base;
+	xTunables best;
+	xTuneResult best_res, current_res;
+	GKeyFile * kf;
+	GError * err = NULL;
+	gchar stamp[32];
+	time_t now = time(NULL);
+	const guint * grid_read;
+	guint n_read;
+	guint q, b, l;
+	gboolean window, ret;
+
+	config.headless = TRUE;
+	config.audio = FALSE;
+	config.loop = FALSE;
+	config.qos = TRUE;		/* the frame counters come from there */
+
+	window = demuxer_has_window(config.demuxer);
+	grid_read = window ? grid_window : grid_blocksize;
+	n_read = window ? G_N_ELEMENTS(grid_window) : G_N_ELEMENTS(grid_blocksize);
+
+	g_print("Autotune: %s, %d s per run, tuning the %s\n", filename, seconds, window ? "demuxer window" : "source block size");
+
+	measure(filename, &config, seconds, &current_res);
+	print_result("current", &config.tune, &current_res);
+	if(!current_res.ok) {
+		g_printerr("Autotune: %s does not play with the current settings\n", filename);
+		return FALSE;
+	}
+	best = config.tune;
+	best_res = current_res;
+
+	for(q = 0; q < G_N_ELEMENTS(grid_queue_buffers); q++) {
+		for(b = 0; b < n_read; b++) {
+			config.tune = base->tune;
+			config.tune.video_queue_buffers = grid_queue_buffers[q];
+			if(window)
+				config.tune.demuxer_window = grid_read[b];
+			else
+				config.tune.source_blocksize = grid_read[b];
+
+			/* max-lateness only means something to a syncing sink */
+			if(!config.tune.sink_sync) {
+				try_tunables(filename, &config, seconds, &best, &best_res);
+				continue;
+			}
+			for(l = 0; l < G_N_ELEMENTS(grid_lateness); l++) {
+				config.tune.max_lateness = grid_lateness[l];
+				try_tunables(filename, &config, seconds, &best, &best_res);
+			}
+		}
+	}
+
+	/* the limits on their own axis, unbounded only wins if clearly better */
+	if(best.video_queue_bytes || best.video_queue_time) {
+		config.tune = best;
+		config.tune.video_queue_bytes = 0;
+		config.tune.video_queue_time = 0;
+		try_tunables(filename, &config, seconds, &best, &best_res);
+	}
+
+	print_result("best", &best, &best_res);
+
+	kf = g_key_file_new();
+	tune_to_keyfile(&best, kf);
+	strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+	g_key_file_set_string(kf, "autotune", "date", stamp);
+	g_key_file_set_string(kf, "autotune", "clip", filename);
+	g_key_file_set_integer(kf, "autotune", "seconds", seconds);
+	result_to_keyfile(kf, "current", &current_res);
+	result_to_keyfile(kf, "best", &best_res);
+
+	ret = tune_save_keyfile(kf, profile, &err);
+	if(ret) {
+		g_print("Autotune: profile written to %s\n", profile);
+	}
+	else {
+		g_printerr("Autotune: %s\n", err->message);
+		g_error_free(err);
+	}
+	g_key_file_free(kf);
+
+	return ret;
+}
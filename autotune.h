@@ -0,0 +1,19 @@
+/*
+ * autotune.h - pipeline tunables search
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#ifndef AUTOTUNE_H_
+#define AUTOTUNE_H_
+
+#include <glib.h>
+
+#include "xplayer.h"
+
+#define AUTOTUNE_SECONDS	10
+
+gboolean autotune_run(const gchar * filename, const xPlayerConfig * base, const gchar * profile, gint seconds);
+
+#endif /* AUTOTUNE_H_ */
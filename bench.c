@@ -0,0 +1,235 @@
+/*
+ * bench.c - benchmark harness
+ *
+ * Each case runs for a fixed wall time on synthetic data and reports frames
+ * per second, so numbers from different boards can be compared directly.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#include <string.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <gst/gst.h>
+#include <glib.h>
+
+#include "bench.h"
+#include "xconvert.h"
+#include "xoverlay.h"
+
+#define BENCH_SECONDS	1.0
+#define BENCH_SRC_W		720
+#define BENCH_SRC_H		576
+#define BENCH_DEMUX_RUNS	3
+#define BENCH_OVERLAY_TEXT	"Asis-BG 00:00:00"
+
+#define FOURCC(a, b, c, d)	((guint32) (a) | ((guint32) (b) << 8) | ((guint32) (c) << 16) | ((guint32) (d) << 24))
+
+static void fill_random(guint8 * data, guint size)
+{
+	guint i;
+
+	for(i = 0; i < size; i++)
+		data[i] = g_random_int() & 0xff;
+}
+
+static void bench_convert_case(const xConvKernels * k, guint32 fourcc, const gchar * format, gint out_w, gint out_h)
+{
+	xConvContext conv;
+	guint size = xconv_input_size(fourcc, BENCH_SRC_W, BENCH_SRC_H);
+	guint8 * src = g_malloc(size);
+	guint8 * dst = g_malloc(out_w * out_h * 4);
+	GTimer * timer = g_timer_new();
+	gdouble elapsed;
+	guint frames = 0;
+
+	memset(&conv, 0, sizeof(xConvContext));
+	fill_random(src, size);
+	xconv_setup(&conv, k, fourcc, BENCH_SRC_W, BENCH_SRC_H, out_w, out_h);
+
+	g_timer_start(timer);
+	do {
+		xconv_frame(&conv, src, dst);
+		frames++;
+	} while((elapsed = g_timer_elapsed(timer, NULL)) < BENCH_SECONDS);
+
+	g_print("%-8s %s %dx%d -> %dx%d: %8.1f fps %8.1f Mpix/s\n", k->name, format,
+			BENCH_SRC_W, BENCH_SRC_H, out_w, out_h, frames / elapsed,
+			frames * (gdouble) out_w * out_h / elapsed / 1e6);
+
+	xconv_free(&conv);
+	g_timer_destroy(timer);
+	g_free(dst);
+	g_free(src);
+}
+
+void bench_convert(gint out_w, gint out_h)
+{
+	gint impl;
+
+	g_print("== xscale: YUV -> BGRx convert and scale ==\n");
+	for(impl = 0; impl < XCONV_IMPL_COUNT; impl++) {
+		const xConvKernels * k = xconv_kernels_get((xConvImpl) impl);
+
+		if(!k)
+			continue;
+
+		bench_convert_case(k, FOURCC('I', '4', '2', '0'), "I420", BENCH_SRC_W, BENCH_SRC_H);
+		bench_convert_case(k, FOURCC('I', '4', '2', '0'), "I420", out_w, out_h);
+		bench_convert_case(k, FOURCC('Y', 'U', 'Y', '2'), "YUY2", BENCH_SRC_W, BENCH_SRC_H);
+		bench_convert_case(k, FOURCC('Y', 'U', 'Y', '2'), "YUY2", out_w, out_h);
+	}
+}
+
+/* the per frame cost is the blend alone, the rendering happens on a text change */
+void bench_overlay(void)
+{
+	guint32 fourcc = FOURCC('I', '4', '2', '0');
+	guint size = xconv_input_size(fourcc, BENCH_SRC_W, BENCH_SRC_H);
+	guint8 * frame = g_malloc(size);
+	GTimer * timer = g_timer_new();
+	xOverlay ov;
+	gdouble elapsed;
+	guint frames;
+	gint impl;
+
+	g_print("== xoverlay: cached text overlay on I420 %dx%d ==\n", BENCH_SRC_W, BENCH_SRC_H);
+
+	memset(&ov, 0, sizeof(xOverlay));
+	fill_random(frame, size);
+
+	frames = 0;
+	g_timer_start(timer);
+	do {
+		xoverlay_render(&ov, BENCH_OVERLAY_TEXT, NULL, 2, 0xffffff);
+		frames++;
+	} while((elapsed = g_timer_elapsed(timer, NULL)) < BENCH_SECONDS);
+	g_print("%-8s %dx%d: %8.1f us\n", "render", ov.w, ov.h, elapsed * 1e6 / frames);
+
+	for(impl = 0; impl < XBLEND_IMPL_COUNT; impl++) {
+		const xBlendKernels * k = xblend_kernels_get((xBlendImpl) impl);
+
+		if(!k)
+			continue;
+
+		frames = 0;
+		g_timer_start(timer);
+		do {
+			xoverlay_blend(&ov, k, frame, fourcc, BENCH_SRC_W, BENCH_SRC_H, 16, 16);
+			frames++;
+		} while((elapsed = g_timer_elapsed(timer, NULL)) < BENCH_SECONDS);
+
+		g_print("%-8s blend: %8.1f us/frame %8.1f fps\n", k->name, elapsed * 1e6 / frames, frames / elapsed);
+	}
+
+	xoverlay_free(&ov);
+	g_timer_destroy(timer);
+	g_free(frame);
+}
+
+static gdouble cpu_time(void)
+{
+	struct rusage ru;
+
+	getrusage(RUSAGE_SELF, &ru);
+
+	return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+/* every demuxer pad goes to a non-syncing fakesink */
+static void bench_pad_added(GstElement * element, GstPad * pad, void * data)
+{
+	GstElement * pipeline = (GstElement *) data;
+	GstElement * sink = gst_element_factory_make("fakesink", NULL);
+	GstPad * sinkpad;
+
+	g_object_set(G_OBJECT(sink), "sync", FALSE, "async", FALSE, NULL);
+	gst_bin_add(GST_BIN(pipeline), sink);
+	gst_element_sync_state_with_parent(sink);
+
+	sinkpad = gst_element_get_static_pad(sink, "sink");
+	gst_pad_link(pad, sinkpad);
+	gst_object_unref(sinkpad);
+}
+
+static gboolean bench_demux_once(const gchar * demuxer, const gchar * filename, gdouble * cpu, gdouble * wall)
+{
+	GstElement * pipeline = gst_pipeline_new("bench");
+	GstElement * source = gst_element_factory_make("filesrc", "source");
+	GstElement * demux = gst_element_factory_make(demuxer, "demux");
+	GstBus * bus;
+	GstMessage * msg;
+	GTimer * timer;
+	gdouble start;
+	gboolean ok;
+
+	if(!source || !demux) {
+		if(source)
+			gst_object_unref(GST_OBJECT(source));
+		if(demux)
+			gst_object_unref(GST_OBJECT(demux));
+		gst_object_unref(GST_OBJECT(pipeline));
+		return FALSE;
+	}
+
+	g_object_set(G_OBJECT(source), "location", filename, "use-mmap", TRUE, NULL);
+	gst_bin_add_many(GST_BIN(pipeline), source, demux, NULL);
+	gst_element_link(source, demux);
+	g_signal_connect(demux, "pad-added", G_CALLBACK(bench_pad_added), pipeline);
+
+	bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline));
+	timer = g_timer_new();
+	start = cpu_time();
+
+	gst_element_set_state(pipeline, GST_STATE_PLAYING);
+	msg = gst_bus_timed_pop_filtered(bus, GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+
+	*cpu = cpu_time() - start;
+	*wall = g_timer_elapsed(timer, NULL);
+	ok = msg && GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS;
+
+	if(msg)
+		gst_message_unref(msg);
+	gst_element_set_state(pipeline, GST_STATE_NULL);
+	g_timer_destroy(timer);
+	gst_object_unref(bus);
+	gst_object_unref(GST_OBJECT(pipeline));
+
+	return ok;
+}
+
+void bench_demux(const gchar * filename)
+{
+	static const gchar * demuxers[] = { "avidemux", "xavidemux", NULL };
+	gint i, run;
+
+	g_print("== demux: %s ==\n", filename);
+	for(i = 0; demuxers[i]; i++) {
+		gdouble best_cpu = G_MAXDOUBLE, best_wall = G_MAXDOUBLE;
+
+		for(run = 0; run < BENCH_DEMUX_RUNS; run++) {
+			gdouble cpu, wall;
+
+			if(!bench_demux_once(demuxers[i], filename, &cpu, &wall)) {
+				best_cpu = -1;
+				break;
+			}
+			best_cpu = MIN(best_cpu, cpu);
+			best_wall = MIN(best_wall, wall);
+		}
+
+		if(best_cpu < 0)
+			g_print("%-10s: failed\n", demuxers[i]);
+		else
+			g_print("%-10s: cpu %8.1f ms, wall %8.1f ms\n", demuxers[i], best_cpu * 1000, best_wall * 1000);
+	}
+}
+
+void bench_run(gint out_w, gint out_h, const gchar * filename)
+{
+	bench_convert(out_w, out_h);
+	bench_overlay();
+	if(filename)
+		bench_demux(filename);
+}
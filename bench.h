@@ -0,0 +1,18 @@
+/*
+ * bench.h - benchmark harness
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <glib.h>
+
+void bench_convert(gint out_w, gint out_h);
+void bench_demux(const gchar * filename);
+void bench_overlay(void);
+void bench_run(gint out_w, gint out_h, const gchar * filename);
+
+#endif /* BENCH_H_ */
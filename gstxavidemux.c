@@ -0,0 +1,1140 @@
+/*
+ * gstxavidemux.c - lightweight pull mode AVI demuxer
+ *
+ * Made for our own content: plain MPEG-4 AVIs played from local storage.
+ * The idx1 or OpenDML index is parsed once into a flat array sorted by file
+ * offset. Chunks are handed out as sub-buffers of a window pulled from
+ * upstream, so with filesrc in mmap mode no payload is ever copied. Seeks
+ * are a binary search in the keyframe list of the main stream.
+ *
+ * Only pull mode is supported.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <gst/gst.h>
+
+#include "gstxavidemux.h"
+
+GST_DEBUG_CATEGORY_STATIC(xavidemux_debug);
+#define GST_CAT_DEFAULT xavidemux_debug
+
+enum {
+	PROP_0,
+	PROP_WINDOW_SIZE,
+};
+
+#define DEFAULT_WINDOW_SIZE	(256 * 1024)
+
+#define FCC(a, b, c, d)		GST_MAKE_FOURCC(a, b, c, d)
+#define FCC_RIFF	FCC('R', 'I', 'F', 'F')
+#define FCC_AVI		FCC('A', 'V', 'I', ' ')
+#define FCC_LIST	FCC('L', 'I', 'S', 'T')
+#define FCC_HDRL	FCC('h', 'd', 'r', 'l')
+#define FCC_STRL	FCC('s', 't', 'r', 'l')
+#define FCC_STRH	FCC('s', 't', 'r', 'h')
+#define FCC_STRF	FCC('s', 't', 'r', 'f')
+#define FCC_INDX	FCC('i', 'n', 'd', 'x')
+#define FCC_MOVI	FCC('m', 'o', 'v', 'i')
+#define FCC_IDX1	FCC('i', 'd', 'x', '1')
+#define FCC_VIDS	FCC('v', 'i', 'd', 's')
+#define FCC_AUDS	FCC('a', 'u', 'd', 's')
+
+#define AVIIF_KEYFRAME			0x10
+#define AVI_INDEX_OF_INDEXES	0x00
+#define AVI_INDEX_OF_CHUNKS		0x01
+#define AVI_DELTA_FRAME			0x80000000
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE("sink",
+		GST_PAD_SINK,
+		GST_PAD_ALWAYS,
+		GST_STATIC_CAPS("video/x-msvideo"));
+
+static GstStaticPadTemplate video_template = GST_STATIC_PAD_TEMPLATE("video_%02d",
+		GST_PAD_SRC,
+		GST_PAD_SOMETIMES,
+		GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate audio_template = GST_STATIC_PAD_TEMPLATE("audio_%02d",
+		GST_PAD_SRC,
+		GST_PAD_SOMETIMES,
+		GST_STATIC_CAPS_ANY);
+
+GST_BOILERPLATE(GstXAviDemux, gst_xavi_demux, GstElement, GST_TYPE_ELEMENT);
+
+static void gst_xavi_demux_loop(GstPad * pad);
+static gboolean gst_xavi_demux_src_event(GstPad * pad, GstEvent * event);
+static gboolean gst_xavi_demux_src_query(GstPad * pad, GstQuery * query);
+
+static void gst_xavi_demux_base_init(gpointer g_class)
+{
+	GstElementClass * element_class = GST_ELEMENT_CLASS(g_class);
+
+	gst_element_class_add_pad_template(element_class, gst_static_pad_template_get(&sink_template));
+	gst_element_class_add_pad_template(element_class, gst_static_pad_template_get(&video_template));
+	gst_element_class_add_pad_template(element_class, gst_static_pad_template_get(&audio_template));
+	gst_element_class_set_details_simple(element_class, "Lightweight AVI demuxer",
+			"Codec/Demuxer",
+			"Zero-copy pull mode AVI demuxer with a flat index",
+			"xpucmo");
+}
+
+/*
+ * index and timestamps
+ */
+
+static GstClockTime stream_time(xAviStream * s, guint64 count)
+{
+	/* CBR audio counts bytes, everything else counts frames */
+	if(s->type == FCC_AUDS && s->sample_size) {
+		if(s->avg_bytes)
+			return gst_util_uint64_scale(count, GST_SECOND, s->avg_bytes);
+		return gst_util_uint64_scale(count, (guint64) s->scale * GST_SECOND, (guint64) s->rate * s->sample_size);
+	}
+
+	return gst_util_uint64_scale(count, (guint64) s->scale * GST_SECOND, s->rate);
+}
+
+static guint32 entry_units(xAviStream * s, guint32 size)
+{
+	return (s->type == FCC_AUDS && s->sample_size) ? size : 1;
+}
+
+static GstClockTime entry_time(GstXAviDemux * xavi, guint n)
+{
+	xAviEntry * e = &xavi->index[n];
+
+	return stream_time(&xavi->streams[e->stream], e->count);
+}
+
+static void index_add(GstXAviDemux * xavi, GArray * entries, guint stream, guint64 offset, guint32 size, gboolean keyframe)
+{
+	xAviStream * s = &xavi->streams[stream];
+	xAviEntry e;
+
+	e.offset = offset;
+	e.size = size;
+	e.count = (guint32) s->total;
+	e.stream = stream;
+	/* audio chunks can always be decoded on their own */
+	e.keyframe = keyframe || s->type == FCC_AUDS;
+	g_array_append_val(entries, e);
+
+	s->total += entry_units(s, size);
+}
+
+static gint compare_offset(gconstpointer a, gconstpointer b)
+{
+	const xAviEntry * ea = a;
+	const xAviEntry * eb = b;
+
+	return ea->offset < eb->offset ? -1 : (ea->offset > eb->offset ? 1 : 0);
+}
+
+static gint chunk_stream(guint32 ckid)
+{
+	gint hi = ckid & 0xff;
+	gint lo = (ckid >> 8) & 0xff;
+
+	/* "00dc", "01wb", ... */
+	if(!g_ascii_isdigit(hi) || !g_ascii_isdigit(lo))
+		return -1;
+
+	return (hi - '0') * 10 + (lo - '0');
+}
+
+static GstFlowReturn xavi_pull(GstXAviDemux * xavi, guint64 offset, guint size, GstBuffer ** buf)
+{
+	GstFlowReturn ret;
+
+	ret = gst_pad_pull_range(xavi->sinkpad, offset, size, buf);
+	if(ret != GST_FLOW_OK)
+		return ret;
+
+	if(GST_BUFFER_SIZE(*buf) < size) {
+		GST_DEBUG_OBJECT(xavi, "short read at %" G_GUINT64_FORMAT ": %u < %u", offset, GST_BUFFER_SIZE(*buf), size);
+		gst_buffer_unref(*buf);
+		*buf = NULL;
+		return GST_FLOW_UNEXPECTED;
+	}
+
+	return GST_FLOW_OK;
+}
+
+/* OpenDML standard index chunk (ix##) */
+static GstFlowReturn parse_odml_chunk_index(GstXAviDemux * xavi, GArray * entries, guint stream, guint64 offset, guint32 size)
+{
+	GstBuffer * buf;
+	GstFlowReturn ret;
+	const guint8 * data;
+	guint64 base;
+	guint32 n, i;
+
+	ret = xavi_pull(xavi, offset, size, &buf);
+	if(ret != GST_FLOW_OK)
+		return ret;
+
+	data = GST_BUFFER_DATA(buf);
+	if(size < 32 || GST_READ_UINT16_LE(data + 8) != 2 || data[11] != AVI_INDEX_OF_CHUNKS) {
+		GST_WARNING_OBJECT(xavi, "unsupported standard index at %" G_GUINT64_FORMAT, offset);
+		gst_buffer_unref(buf);
+		return GST_FLOW_OK;
+	}
+
+	n = GST_READ_UINT32_LE(data + 12);
+	base = GST_READ_UINT64_LE(data + 20);
+	n = MIN(n, (size - 32) / 8);
+
+	for(i = 0; i < n; i++) {
+		guint32 off = GST_READ_UINT32_LE(data + 32 + i * 8);
+		guint32 len = GST_READ_UINT32_LE(data + 36 + i * 8);
+
+		index_add(xavi, entries, stream, base + off, len & ~AVI_DELTA_FRAME, !(len & AVI_DELTA_FRAME));
+	}
+
+	gst_buffer_unref(buf);
+
+	return GST_FLOW_OK;
+}
+
+/* returns the streams that were indexed, as a bit mask */
+static guint parse_odml_index(GstXAviDemux * xavi, GArray * entries)
+{
+	guint i, j;
+	guint found = 0;
+
+	for(i = 0; i < xavi->n_streams; i++) {
+		xAviStream * s = &xavi->streams[i];
+		guint len = entries->len;
+		guint32 n;
+
+		if(!s->indx || s->indx_size < 24 || s->indx[3] != AVI_INDEX_OF_INDEXES)
+			continue;
+
+		n = MIN(GST_READ_UINT32_LE(s->indx + 4), (s->indx_size - 24) / 16);
+		for(j = 0; j < n; j++) {
+			const guint8 * e = s->indx + 24 + j * 16;
+
+			if(parse_odml_chunk_index(xavi, entries, i, GST_READ_UINT64_LE(e), GST_READ_UINT32_LE(e + 8)) != GST_FLOW_OK)
+				break;
+		}
+		if(j < n) {
+			/* drop what this stream got, one of the fallbacks indexes it */
+			g_array_set_size(entries, len);
+			s->total = 0;
+			continue;
+		}
+		found |= 1 << i;
+	}
+
+	return found;
+}
+
+/* streams in done already have their entries */
+static gboolean parse_idx1(GstXAviDemux * xavi, GArray * entries, guint done)
+{
+	GstBuffer * buf;
+	const guint8 * data;
+	guint64 base = 0;
+	guint32 n, i;
+
+	if(!xavi->idx1_offset || xavi->idx1_size < 16)
+		return FALSE;
+
+	if(xavi_pull(xavi, xavi->idx1_offset, xavi->idx1_size, &buf) != GST_FLOW_OK)
+		return FALSE;
+
+	data = GST_BUFFER_DATA(buf);
+	n = xavi->idx1_size / 16;
+
+	/* offsets are usually relative to the 'movi' fourcc, some muxers write them absolute */
+	for(i = 0; i < n; i++) {
+		if(chunk_stream(GST_READ_UINT32_LE(data + i * 16)) >= 0) {
+			if(GST_READ_UINT32_LE(data + i * 16 + 8) < xavi->movi_offset)
+				base = xavi->movi_offset;
+			break;
+		}
+	}
+
+	for(i = 0; i < n; i++, data += 16) {
+		gint stream = chunk_stream(GST_READ_UINT32_LE(data));
+
+		if(stream < 0 || stream >= xavi->n_streams || (done & (1 << stream)))
+			continue;
+
+		index_add(xavi, entries, stream, base + GST_READ_UINT32_LE(data + 8) + 8,
+				GST_READ_UINT32_LE(data + 12), GST_READ_UINT32_LE(data + 4) & AVIIF_KEYFRAME);
+	}
+
+	gst_buffer_unref(buf);
+
+	return TRUE;
+}
+
+/* no usable index: walk the chunk headers of the movi list */
+static void scan_movi(GstXAviDemux * xavi, GArray * entries, guint done)
+{
+	guint64 offset = xavi->movi_offset + 4;
+	gboolean first_video = TRUE;
+
+	GST_WARNING_OBJECT(xavi, "no index, scanning movi list, seeking will only go to the start");
+
+	while(offset + 8 <= xavi->movi_end) {
+		GstBuffer * buf;
+		guint32 fcc, size;
+		gint stream;
+
+		if(xavi_pull(xavi, offset, 8, &buf) != GST_FLOW_OK)
+			break;
+		fcc = GST_READ_UINT32_LE(GST_BUFFER_DATA(buf));
+		size = GST_READ_UINT32_LE(GST_BUFFER_DATA(buf) + 4);
+		gst_buffer_unref(buf);
+
+		if(fcc == FCC_LIST) {
+			/* rec lists, step inside */
+			offset += 12;
+			continue;
+		}
+
+		stream = chunk_stream(fcc);
+		if(stream >= 0 && stream < xavi->n_streams && !(done & (1 << stream))) {
+			gboolean video = xavi->streams[stream].type == FCC_VIDS;
+
+			index_add(xavi, entries, stream, offset + 8, size, video && first_video);
+			if(video)
+				first_video = FALSE;
+		}
+		offset += 8 + GST_ROUND_UP_2(size);
+	}
+}
+
+static gboolean build_index(GstXAviDemux * xavi)
+{
+	GArray * entries = g_array_new(FALSE, FALSE, sizeof(xAviEntry));
+	guint i, done, wanted = 0;
+
+	for(i = 0; i < xavi->n_streams; i++) {
+		if(xavi->streams[i].pad)
+			wanted |= 1 << i;
+	}
+
+	/* mixed files often only have an OpenDML index for the video */
+	done = parse_odml_index(xavi, entries);
+	if((done & wanted) != wanted) {
+		guint len = entries->len;
+
+		if(!parse_idx1(xavi, entries, done) || entries->len == len)
+			scan_movi(xavi, entries, done);
+	}
+	g_array_sort(entries, compare_offset);
+
+	xavi->n_entries = entries->len;
+	xavi->index = (xAviEntry *) g_array_free(entries, FALSE);
+
+	if(!xavi->n_entries)
+		return FALSE;
+
+	/* seek on the first video stream, or the first stream at all */
+	xavi->main_stream = xavi->index[0].stream;
+	for(i = 0; i < xavi->n_streams; i++) {
+		if(xavi->streams[i].type == FCC_VIDS && xavi->streams[i].pad) {
+			xavi->main_stream = i;
+			break;
+		}
+	}
+
+	xavi->keyframes = g_new(guint, xavi->n_entries);
+	xavi->n_keyframes = 0;
+	for(i = 0; i < xavi->n_entries; i++) {
+		if(xavi->index[i].stream == xavi->main_stream && xavi->index[i].keyframe)
+			xavi->keyframes[xavi->n_keyframes++] = i;
+	}
+	xavi->keyframes = g_renew(guint, xavi->keyframes, MAX(xavi->n_keyframes, 1));
+
+	xavi->duration = 0;
+	for(i = 0; i < xavi->n_streams; i++) {
+		if(xavi->streams[i].rate && xavi->streams[i].scale)
+			xavi->duration = MAX(xavi->duration, stream_time(&xavi->streams[i], xavi->streams[i].total));
+	}
+	gst_segment_set_duration(&xavi->segment, GST_FORMAT_TIME, xavi->duration);
+
+	GST_INFO_OBJECT(xavi, "%u index entries, %u keyframes, duration %" GST_TIME_FORMAT,
+			xavi->n_entries, xavi->n_keyframes, GST_TIME_ARGS(xavi->duration));
+
+	return TRUE;
+}
+
+/* last keyframe at or before ts */
+static guint find_keyframe(GstXAviDemux * xavi, GstClockTime ts)
+{
+	guint lo = 0, hi = xavi->n_keyframes;
+
+	if(!xavi->n_keyframes)
+		return 0;
+
+	while(hi - lo > 1) {
+		guint mid = (lo + hi) / 2;
+
+		if(entry_time(xavi, xavi->keyframes[mid]) <= ts)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	return xavi->keyframes[lo];
+}
+
+/*
+ * headers
+ */
+
+static GstCaps * video_caps(xAviStream * s)
+{
+	const guint8 * bih = s->strf;
+	guint32 fcc;
+	gchar c[4];
+	GstCaps * caps;
+	gint i;
+
+	if(!bih || s->strf_size < 40)
+		return NULL;
+
+	fcc = GST_READ_UINT32_LE(bih + 16);
+	if(!fcc)
+		fcc = s->handler;
+	for(i = 0; i < 4; i++)
+		c[i] = g_ascii_toupper((fcc >> (i * 8)) & 0xff);
+	fcc = GST_MAKE_FOURCC(c[0], c[1], c[2], c[3]);
+
+	switch(fcc) {
+	case GST_MAKE_FOURCC('X', 'V', 'I', 'D'):
+	case GST_MAKE_FOURCC('D', 'I', 'V', 'X'):
+	case GST_MAKE_FOURCC('D', 'X', '5', '0'):
+	case GST_MAKE_FOURCC('F', 'M', 'P', '4'):
+	case GST_MAKE_FOURCC('M', 'P', '4', 'V'):
+		caps = gst_caps_new_simple("video/mpeg", "mpegversion", G_TYPE_INT, 4,
+				"systemstream", G_TYPE_BOOLEAN, FALSE, NULL);
+		break;
+	case GST_MAKE_FOURCC('H', '2', '6', '4'):
+	case GST_MAKE_FOURCC('X', '2', '6', '4'):
+	case GST_MAKE_FOURCC('A', 'V', 'C', '1'):
+		caps = gst_caps_new_simple("video/x-h264", NULL);
+		break;
+	case GST_MAKE_FOURCC('H', '2', '6', '3'):
+		caps = gst_caps_new_simple("video/x-h263", "variant", G_TYPE_STRING, "itu", NULL);
+		break;
+	case GST_MAKE_FOURCC('M', 'J', 'P', 'G'):
+		caps = gst_caps_new_simple("image/jpeg", NULL);
+		break;
+	default:
+		return NULL;
+	}
+
+	gst_caps_set_simple(caps, "width", G_TYPE_INT, (gint) GST_READ_UINT32_LE(bih + 4),
+			"height", G_TYPE_INT, ABS((gint) GST_READ_UINT32_LE(bih + 8)),
+			"framerate", GST_TYPE_FRACTION, s->rate, s->scale, NULL);
+
+	if(s->strf_size > 40) {
+		GstBuffer * codec_data = gst_buffer_new_and_alloc(s->strf_size - 40);
+
+		memcpy(GST_BUFFER_DATA(codec_data), bih + 40, s->strf_size - 40);
+		gst_caps_set_simple(caps, "codec_data", GST_TYPE_BUFFER, codec_data, NULL);
+		gst_buffer_unref(codec_data);
+	}
+
+	return caps;
+}
+
+static GstCaps * audio_caps(xAviStream * s)
+{
+	const guint8 * wfx = s->strf;
+	gint channels, rate, bits;
+	GstCaps * caps;
+
+	if(!wfx || s->strf_size < 16)
+		return NULL;
+
+	channels = GST_READ_UINT16_LE(wfx + 2);
+	rate = GST_READ_UINT32_LE(wfx + 4);
+	bits = GST_READ_UINT16_LE(wfx + 14);
+	s->avg_bytes = GST_READ_UINT32_LE(wfx + 8);
+
+	switch(GST_READ_UINT16_LE(wfx)) {
+	case 0x0001:
+		caps = gst_caps_new_simple("audio/x-raw-int",
+				"endianness", G_TYPE_INT, G_LITTLE_ENDIAN,
+				"signed", G_TYPE_BOOLEAN, bits > 8,
+				"width", G_TYPE_INT, bits, "depth", G_TYPE_INT, bits, NULL);
+		break;
+	case 0x0050:
+		caps = gst_caps_new_simple("audio/mpeg", "mpegversion", G_TYPE_INT, 1, "layer", G_TYPE_INT, 2, NULL);
+		break;
+	case 0x0055:
+		caps = gst_caps_new_simple("audio/mpeg", "mpegversion", G_TYPE_INT, 1, "layer", G_TYPE_INT, 3, NULL);
+		break;
+	case 0x00ff:
+		caps = gst_caps_new_simple("audio/mpeg", "mpegversion", G_TYPE_INT, 4, NULL);
+		break;
+	case 0x2000:
+		caps = gst_caps_new_simple("audio/x-ac3", NULL);
+		break;
+	default:
+		return NULL;
+	}
+
+	gst_caps_set_simple(caps, "rate", G_TYPE_INT, rate, "channels", G_TYPE_INT, channels, NULL);
+
+	if(s->strf_size > 18 && GST_READ_UINT16_LE(wfx + 16)) {
+		guint extra = MIN(GST_READ_UINT16_LE(wfx + 16), s->strf_size - 18);
+		GstBuffer * codec_data = gst_buffer_new_and_alloc(extra);
+
+		memcpy(GST_BUFFER_DATA(codec_data), wfx + 18, extra);
+		gst_caps_set_simple(caps, "codec_data", GST_TYPE_BUFFER, codec_data, NULL);
+		gst_buffer_unref(codec_data);
+	}
+
+	return caps;
+}
+
+static void parse_strl(GstXAviDemux * xavi, const guint8 * data, guint size)
+{
+	xAviStream * s;
+	guint pos = 0;
+
+	if(xavi->n_streams >= XAVI_MAX_STREAMS)
+		return;
+	s = &xavi->streams[xavi->n_streams++];
+
+	while(pos + 8 <= size) {
+		guint32 fcc = GST_READ_UINT32_LE(data + pos);
+		guint32 len = MIN(GST_READ_UINT32_LE(data + pos + 4), size - pos - 8);
+		const guint8 * d = data + pos + 8;
+
+		switch(fcc) {
+		case FCC_STRH:
+			if(len >= 48) {
+				s->type = GST_READ_UINT32_LE(d);
+				s->handler = GST_READ_UINT32_LE(d + 4);
+				s->scale = GST_READ_UINT32_LE(d + 20);
+				s->rate = GST_READ_UINT32_LE(d + 24);
+				s->sample_size = GST_READ_UINT32_LE(d + 44);
+			}
+			break;
+		case FCC_STRF:
+			g_free(s->strf);
+			s->strf = g_memdup(d, len);
+			s->strf_size = len;
+			break;
+		case FCC_INDX:
+			g_free(s->indx);
+			s->indx = g_memdup(d, len);
+			s->indx_size = len;
+			break;
+		default:
+			break;
+		}
+		pos += 8 + GST_ROUND_UP_2(len);
+	}
+}
+
+static void parse_hdrl(GstXAviDemux * xavi, const guint8 * data, guint size)
+{
+	guint pos = 0;
+
+	while(pos + 12 <= size) {
+		guint32 fcc = GST_READ_UINT32_LE(data + pos);
+		guint32 len = MIN(GST_READ_UINT32_LE(data + pos + 4), size - pos - 8);
+
+		if(fcc == FCC_LIST && len >= 4 && GST_READ_UINT32_LE(data + pos + 8) == FCC_STRL)
+			parse_strl(xavi, data + pos + 12, len - 4);
+		pos += 8 + GST_ROUND_UP_2(len);
+	}
+}
+
+static GstFlowReturn parse_headers(GstXAviDemux * xavi)
+{
+	GstFormat fmt = GST_FORMAT_BYTES;
+	gint64 filesize;
+	GstBuffer * buf;
+	GstFlowReturn ret;
+	guint64 offset;
+
+	if(!gst_pad_query_peer_duration(xavi->sinkpad, &fmt, &filesize) || filesize < 12) {
+		GST_ELEMENT_ERROR(xavi, STREAM, DEMUX, (NULL), ("could not get the file size"));
+		return GST_FLOW_ERROR;
+	}
+	xavi->filesize = filesize;
+
+	ret = xavi_pull(xavi, 0, 12, &buf);
+	if(ret != GST_FLOW_OK)
+		return ret;
+	if(GST_READ_UINT32_LE(GST_BUFFER_DATA(buf)) != FCC_RIFF || GST_READ_UINT32_LE(GST_BUFFER_DATA(buf) + 8) != FCC_AVI) {
+		gst_buffer_unref(buf);
+		GST_ELEMENT_ERROR(xavi, STREAM, WRONG_TYPE, (NULL), ("not an AVI file"));
+		return GST_FLOW_ERROR;
+	}
+	gst_buffer_unref(buf);
+
+	for(offset = 12; offset + 8 <= xavi->filesize; ) {
+		guint32 fcc, size, type = 0;
+		guint hdr = MIN(12, xavi->filesize - offset);
+
+		ret = xavi_pull(xavi, offset, hdr, &buf);
+		if(ret != GST_FLOW_OK)
+			return ret;
+		fcc = GST_READ_UINT32_LE(GST_BUFFER_DATA(buf));
+		size = GST_READ_UINT32_LE(GST_BUFFER_DATA(buf) + 4);
+		if(hdr == 12)
+			type = GST_READ_UINT32_LE(GST_BUFFER_DATA(buf) + 8);
+		gst_buffer_unref(buf);
+
+		if(fcc == FCC_LIST && type == FCC_HDRL && size >= 4) {
+			ret = xavi_pull(xavi, offset + 12, size - 4, &buf);
+			if(ret != GST_FLOW_OK)
+				return ret;
+			parse_hdrl(xavi, GST_BUFFER_DATA(buf), GST_BUFFER_SIZE(buf));
+			gst_buffer_unref(buf);
+		}
+		else if(fcc == FCC_LIST && type == FCC_MOVI) {
+			xavi->movi_offset = offset + 8;
+			xavi->movi_end = MIN(offset + 8 + size, xavi->filesize);
+		}
+		else if(fcc == FCC_IDX1) {
+			xavi->idx1_offset = offset + 8;
+			xavi->idx1_size = MIN(size, xavi->filesize - xavi->idx1_offset);
+		}
+		/* OpenDML RIFF-AVIX extensions are reached through the indx chunks */
+		offset += 8 + GST_ROUND_UP_2((guint64) size);
+	}
+
+	if(!xavi->n_streams || !xavi->movi_offset) {
+		GST_ELEMENT_ERROR(xavi, STREAM, DEMUX, (NULL), ("no streams or no movi list"));
+		return GST_FLOW_ERROR;
+	}
+
+	return GST_FLOW_OK;
+}
+
+static void expose_pads(GstXAviDemux * xavi)
+{
+	guint i, n_video = 0, n_audio = 0;
+
+	for(i = 0; i < xavi->n_streams; i++) {
+		xAviStream * s = &xavi->streams[i];
+		GstPadTemplate * templ;
+		GstCaps * caps;
+		gchar * name;
+
+		if(!s->rate || !s->scale)
+			continue;
+
+		if(s->type == FCC_VIDS) {
+			caps = video_caps(s);
+			name = g_strdup_printf("video_%02d", n_video++);
+			templ = gst_static_pad_template_get(&video_template);
+		}
+		else if(s->type == FCC_AUDS) {
+			caps = audio_caps(s);
+			name = g_strdup_printf("audio_%02d", n_audio++);
+			templ = gst_static_pad_template_get(&audio_template);
+		}
+		else {
+			continue;
+		}
+
+		if(!caps) {
+			GST_WARNING_OBJECT(xavi, "stream %u: unsupported format, skipped", i);
+			g_free(name);
+			gst_object_unref(templ);
+			continue;
+		}
+
+		s->pad = gst_pad_new_from_template(templ, name);
+		gst_object_unref(templ);
+		g_free(name);
+
+		gst_pad_set_event_function(s->pad, GST_DEBUG_FUNCPTR(gst_xavi_demux_src_event));
+		gst_pad_set_query_function(s->pad, GST_DEBUG_FUNCPTR(gst_xavi_demux_src_query));
+		gst_pad_set_caps(s->pad, caps);
+		gst_pad_use_fixed_caps(s->pad);
+		gst_caps_unref(caps);
+
+		s->discont = TRUE;
+		s->last_flow = GST_FLOW_OK;
+		gst_pad_set_active(s->pad, TRUE);
+		gst_element_add_pad(GST_ELEMENT(xavi), s->pad);
+	}
+
+	gst_element_no_more_pads(GST_ELEMENT(xavi));
+}
+
+/*
+ * streaming
+ */
+
+static GstFlowReturn get_chunk(GstXAviDemux * xavi, guint64 offset, guint32 size, GstBuffer ** buf)
+{
+	GstFlowReturn ret;
+
+	if(offset + size > xavi->filesize)
+		return GST_FLOW_UNEXPECTED;
+
+	if(!xavi->window || offset < xavi->window_offset ||
+			offset + size > xavi->window_offset + GST_BUFFER_SIZE(xavi->window)) {
+		guint len = MAX(xavi->window_size, size);
+
+		if(offset + len > xavi->filesize)
+			len = xavi->filesize - offset;
+
+		if(xavi->window) {
+			gst_buffer_unref(xavi->window);
+			xavi->window = NULL;
+		}
+
+		ret = xavi_pull(xavi, offset, len, &xavi->window);
+		if(ret != GST_FLOW_OK)
+			return ret;
+		xavi->window_offset = offset;
+	}
+
+	*buf = gst_buffer_create_sub(xavi->window, offset - xavi->window_offset, size);
+
+	return GST_FLOW_OK;
+}
+
+static GstFlowReturn combine_flows(GstXAviDemux * xavi, xAviStream * s, GstFlowReturn ret)
+{
+	guint i;
+
+	s->last_flow = ret;
+	if(ret != GST_FLOW_NOT_LINKED)
+		return ret;
+
+	/* not-linked is only an error when no stream is linked */
+	for(i = 0; i < xavi->n_streams; i++) {
+		if(xavi->streams[i].pad && xavi->streams[i].last_flow != GST_FLOW_NOT_LINKED)
+			return GST_FLOW_OK;
+	}
+
+	return GST_FLOW_NOT_LINKED;
+}
+
+static gboolean has_pads(GstXAviDemux * xavi)
+{
+	guint i;
+
+	for(i = 0; i < xavi->n_streams; i++) {
+		if(xavi->streams[i].pad)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+static void push_event(GstXAviDemux * xavi, GstEvent * event)
+{
+	guint i;
+
+	for(i = 0; i < xavi->n_streams; i++) {
+		if(xavi->streams[i].pad)
+			gst_pad_push_event(xavi->streams[i].pad, gst_event_ref(event));
+	}
+	gst_event_unref(event);
+}
+
+static GstFlowReturn push_next(GstXAviDemux * xavi)
+{
+	xAviEntry * e;
+	xAviStream * s;
+	GstClockTime ts;
+	GstBuffer * buf;
+	GstFlowReturn ret;
+
+	if(xavi->cur >= xavi->n_entries)
+		return GST_FLOW_UNEXPECTED;
+
+	e = &xavi->index[xavi->cur++];
+	s = &xavi->streams[e->stream];
+	if(!s->pad || !e->size)
+		return GST_FLOW_OK;
+
+	ts = stream_time(s, e->count);
+	if(e->stream == xavi->main_stream && GST_CLOCK_TIME_IS_VALID(xavi->segment.stop) && ts >= (GstClockTime) xavi->segment.stop)
+		return GST_FLOW_UNEXPECTED;
+
+	ret = get_chunk(xavi, e->offset, e->size, &buf);
+	if(ret != GST_FLOW_OK)
+		return ret;
+
+	GST_BUFFER_TIMESTAMP(buf) = ts;
+	GST_BUFFER_DURATION(buf) = stream_time(s, e->count + entry_units(s, e->size)) - ts;
+	GST_BUFFER_OFFSET(buf) = e->count;
+	if(!e->keyframe)
+		GST_BUFFER_FLAG_SET(buf, GST_BUFFER_FLAG_DELTA_UNIT);
+	if(s->discont) {
+		GST_BUFFER_FLAG_SET(buf, GST_BUFFER_FLAG_DISCONT);
+		s->discont = FALSE;
+	}
+	gst_buffer_set_caps(buf, GST_PAD_CAPS(s->pad));
+
+	if(e->stream == xavi->main_stream)
+		gst_segment_set_last_stop(&xavi->segment, GST_FORMAT_TIME, ts);
+
+	ret = gst_pad_push(s->pad, buf);
+
+	return combine_flows(xavi, s, ret);
+}
+
+static void gst_xavi_demux_loop(GstPad * pad)
+{
+	GstXAviDemux * xavi = GST_XAVI_DEMUX(gst_pad_get_parent(pad));
+	GstFlowReturn ret;
+
+	if(xavi->state == XAVI_STATE_HEADER) {
+		ret = parse_headers(xavi);
+		if(ret != GST_FLOW_OK)
+			goto pause;
+
+		expose_pads(xavi);
+		if(!has_pads(xavi)) {
+			GST_ELEMENT_ERROR(xavi, STREAM, WRONG_TYPE, (NULL), ("no supported streams"));
+			ret = GST_FLOW_ERROR;
+			goto pause;
+		}
+		if(!build_index(xavi)) {
+			GST_ELEMENT_ERROR(xavi, STREAM, DEMUX, (NULL), ("no chunks found"));
+			ret = GST_FLOW_ERROR;
+			goto pause;
+		}
+		xavi->state = XAVI_STATE_DATA;
+		xavi->need_segment = TRUE;
+	}
+
+	if(xavi->need_segment) {
+		push_event(xavi, gst_event_new_new_segment(FALSE, xavi->segment.rate, GST_FORMAT_TIME,
+				xavi->segment.start, xavi->segment.stop, xavi->segment.time));
+		xavi->need_segment = FALSE;
+	}
+
+	ret = push_next(xavi);
+	if(ret != GST_FLOW_OK)
+		goto pause;
+
+	gst_object_unref(xavi);
+	return;
+
+pause:
+	GST_LOG_OBJECT(xavi, "pausing task, reason %s", gst_flow_get_name(ret));
+	gst_pad_pause_task(xavi->sinkpad);
+
+	if(ret == GST_FLOW_UNEXPECTED && !has_pads(xavi)) {
+		/* nothing downstream to take the EOS, preroll would wait forever */
+		GST_ELEMENT_ERROR(xavi, STREAM, DEMUX, (NULL), ("truncated or broken headers"));
+	}
+	else if(ret == GST_FLOW_UNEXPECTED) {
+		if(xavi->segment.flags & GST_SEEK_FLAG_SEGMENT) {
+			gint64 stop = xavi->segment.stop;
+
+			if(stop == -1)
+				stop = xavi->duration;
+			gst_element_post_message(GST_ELEMENT(xavi),
+					gst_message_new_segment_done(GST_OBJECT(xavi), GST_FORMAT_TIME, stop));
+		}
+		else {
+			push_event(xavi, gst_event_new_eos());
+		}
+	}
+	else if(ret == GST_FLOW_NOT_LINKED || ret < GST_FLOW_UNEXPECTED) {
+		GST_ELEMENT_ERROR(xavi, STREAM, FAILED, (NULL), ("streaming stopped, reason %s", gst_flow_get_name(ret)));
+		push_event(xavi, gst_event_new_eos());
+	}
+
+	gst_object_unref(xavi);
+}
+
+/*
+ * seeking and queries
+ */
+
+static gboolean handle_seek(GstXAviDemux * xavi, GstEvent * event)
+{
+	gdouble rate;
+	GstFormat format;
+	GstSeekFlags flags;
+	GstSeekType cur_type, stop_type;
+	gint64 cur, stop;
+	gboolean flush, update;
+	GstSegment seeksegment;
+	guint i, idx;
+
+	gst_event_parse_seek(event, &rate, &format, &flags, &cur_type, &cur, &stop_type, &stop);
+
+	if(format != GST_FORMAT_TIME || rate <= 0.0 || xavi->state != XAVI_STATE_DATA)
+		return FALSE;
+
+	flush = !!(flags & GST_SEEK_FLAG_FLUSH);
+
+	if(flush) {
+		gst_pad_push_event(xavi->sinkpad, gst_event_new_flush_start());
+		push_event(xavi, gst_event_new_flush_start());
+	}
+	else {
+		gst_pad_pause_task(xavi->sinkpad);
+	}
+
+	GST_PAD_STREAM_LOCK(xavi->sinkpad);
+
+	memcpy(&seeksegment, &xavi->segment, sizeof(GstSegment));
+	gst_segment_set_seek(&seeksegment, rate, format, flags, cur_type, cur, stop_type, stop, &update);
+
+	idx = find_keyframe(xavi, seeksegment.last_stop);
+	if(flags & GST_SEEK_FLAG_KEY_UNIT) {
+		seeksegment.start = seeksegment.last_stop = seeksegment.time = entry_time(xavi, idx);
+	}
+
+	GST_DEBUG_OBJECT(xavi, "seek to %" GST_TIME_FORMAT ", entry %u", GST_TIME_ARGS(seeksegment.last_stop), idx);
+
+	if(flush) {
+		gst_pad_push_event(xavi->sinkpad, gst_event_new_flush_stop());
+		push_event(xavi, gst_event_new_flush_stop());
+	}
+
+	if(seeksegment.flags & GST_SEEK_FLAG_SEGMENT) {
+		gst_element_post_message(GST_ELEMENT(xavi),
+				gst_message_new_segment_start(GST_OBJECT(xavi), GST_FORMAT_TIME, seeksegment.last_stop));
+	}
+
+	memcpy(&xavi->segment, &seeksegment, sizeof(GstSegment));
+	xavi->cur = idx;
+	xavi->need_segment = TRUE;
+	for(i = 0; i < xavi->n_streams; i++) {
+		xavi->streams[i].discont = TRUE;
+		xavi->streams[i].last_flow = GST_FLOW_OK;
+	}
+
+	gst_pad_start_task(xavi->sinkpad, (GstTaskFunction) gst_xavi_demux_loop, xavi->sinkpad);
+
+	GST_PAD_STREAM_UNLOCK(xavi->sinkpad);
+
+	return TRUE;
+}
+
+static gboolean gst_xavi_demux_src_event(GstPad * pad, GstEvent * event)
+{
+	GstXAviDemux * xavi = GST_XAVI_DEMUX(gst_pad_get_parent(pad));
+	gboolean res;
+
+	switch(GST_EVENT_TYPE(event)) {
+	case GST_EVENT_SEEK:
+		res = handle_seek(xavi, event);
+		gst_event_unref(event);
+		break;
+	default:
+		res = gst_pad_event_default(pad, event);
+		break;
+	}
+
+	gst_object_unref(xavi);
+
+	return res;
+}
+
+static gboolean gst_xavi_demux_src_query(GstPad * pad, GstQuery * query)
+{
+	GstXAviDemux * xavi = GST_XAVI_DEMUX(gst_pad_get_parent(pad));
+	GstFormat format;
+	gboolean res = TRUE;
+
+	switch(GST_QUERY_TYPE(query)) {
+	case GST_QUERY_DURATION:
+		gst_query_parse_duration(query, &format, NULL);
+		if(format == GST_FORMAT_TIME && xavi->state == XAVI_STATE_DATA)
+			gst_query_set_duration(query, GST_FORMAT_TIME, xavi->duration);
+		else
+			res = FALSE;
+		break;
+	case GST_QUERY_POSITION:
+		gst_query_parse_position(query, &format, NULL);
+		if(format == GST_FORMAT_TIME && xavi->state == XAVI_STATE_DATA)
+			gst_query_set_position(query, GST_FORMAT_TIME, xavi->segment.last_stop);
+		else
+			res = FALSE;
+		break;
+	case GST_QUERY_SEEKING:
+		gst_query_parse_seeking(query, &format, NULL, NULL, NULL);
+		if(format == GST_FORMAT_TIME)
+			gst_query_set_seeking(query, GST_FORMAT_TIME, xavi->n_keyframes > 1, 0, xavi->duration);
+		else
+			res = FALSE;
+		break;
+	default:
+		res = gst_pad_query_default(pad, query);
+		break;
+	}
+
+	gst_object_unref(xavi);
+
+	return res;
+}
+
+/*
+ * activation and state
+ */
+
+static gboolean gst_xavi_demux_sink_activate(GstPad * pad)
+{
+	if(gst_pad_check_pull_range(pad))
+		return gst_pad_activate_pull(pad, TRUE);
+
+	GST_ERROR_OBJECT(pad, "upstream does not support pull mode");
+
+	return FALSE;
+}
+
+static gboolean gst_xavi_demux_sink_activate_pull(GstPad * pad, gboolean active)
+{
+	if(active)
+		return gst_pad_start_task(pad, (GstTaskFunction) gst_xavi_demux_loop, pad);
+
+	return gst_pad_stop_task(pad);
+}
+
+static void gst_xavi_demux_reset(GstXAviDemux * xavi)
+{
+	guint i;
+
+	for(i = 0; i < xavi->n_streams; i++) {
+		xAviStream * s = &xavi->streams[i];
+
+		if(s->pad)
+			gst_element_remove_pad(GST_ELEMENT(xavi), s->pad);
+		g_free(s->strf);
+		g_free(s->indx);
+	}
+	memset(xavi->streams, 0, sizeof(xavi->streams));
+	xavi->n_streams = 0;
+
+	g_free(xavi->index);
+	xavi->index = NULL;
+	xavi->n_entries = 0;
+	g_free(xavi->keyframes);
+	xavi->keyframes = NULL;
+	xavi->n_keyframes = 0;
+	xavi->cur = 0;
+
+	if(xavi->window) {
+		gst_buffer_unref(xavi->window);
+		xavi->window = NULL;
+	}
+
+	xavi->state = XAVI_STATE_HEADER;
+	xavi->filesize = 0;
+	xavi->movi_offset = xavi->movi_end = 0;
+	xavi->idx1_offset = 0;
+	xavi->idx1_size = 0;
+	xavi->main_stream = 0;
+	xavi->duration = GST_CLOCK_TIME_NONE;
+	xavi->need_segment = FALSE;
+	gst_segment_init(&xavi->segment, GST_FORMAT_TIME);
+}
+
+static GstStateChangeReturn gst_xavi_demux_change_state(GstElement * element, GstStateChange transition)
+{
+	GstXAviDemux * xavi = GST_XAVI_DEMUX(element);
+	GstStateChangeReturn ret;
+
+	if(transition == GST_STATE_CHANGE_READY_TO_PAUSED)
+		gst_xavi_demux_reset(xavi);
+
+	ret = GST_ELEMENT_CLASS(parent_class)->change_state(element, transition);
+	if(ret == GST_STATE_CHANGE_FAILURE)
+		return ret;
+
+	if(transition == GST_STATE_CHANGE_PAUSED_TO_READY)
+		gst_xavi_demux_reset(xavi);
+
+	return ret;
+}
+
+static void gst_xavi_demux_set_property(GObject * object, guint prop_id, const GValue * value, GParamSpec * pspec)
+{
+	GstXAviDemux * xavi = GST_XAVI_DEMUX(object);
+
+	switch(prop_id) {
+	case PROP_WINDOW_SIZE:
+		xavi->window_size = g_value_get_uint(value);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+		break;
+	}
+}
+
+static void gst_xavi_demux_get_property(GObject * object, guint prop_id, GValue * value, GParamSpec * pspec)
+{
+	GstXAviDemux * xavi = GST_XAVI_DEMUX(object);
+
+	switch(prop_id) {
+	case PROP_WINDOW_SIZE:
+		g_value_set_uint(value, xavi->window_size);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+		break;
+	}
+}
+
+static void gst_xavi_demux_finalize(GObject * object)
+{
+	GstXAviDemux * xavi = GST_XAVI_DEMUX(object);
+	guint i;
+
+	/* the pads went with dispose, only the copies are left */
+	for(i = 0; i < xavi->n_streams; i++) {
+		g_free(xavi->streams[i].strf);
+		g_free(xavi->streams[i].indx);
+	}
+	g_free(xavi->index);
+	g_free(xavi->keyframes);
+	if(xavi->window)
+		gst_buffer_unref(xavi->window);
+
+	G_OBJECT_CLASS(parent_class)->finalize(object);
+}
+
+static void gst_xavi_demux_class_init(GstXAviDemuxClass * klass)
+{
+	GObjectClass * gobject_class = G_OBJECT_CLASS(klass);
+	GstElementClass * element_class = GST_ELEMENT_CLASS(klass);
+
+	GST_DEBUG_CATEGORY_INIT(xavidemux_debug, "xavidemux", 0, "lightweight AVI demuxer");
+
+	gobject_class->set_property = gst_xavi_demux_set_property;
+	gobject_class->get_property = gst_xavi_demux_get_property;
+	gobject_class->finalize = gst_xavi_demux_finalize;
+
+	g_object_class_install_property(gobject_class, PROP_WINDOW_SIZE,
+			g_param_spec_uint("window-size", "Window size", "Bytes pulled from upstream at once, chunks are sub-buffers of it",
+					4096, G_MAXUINT, DEFAULT_WINDOW_SIZE, G_PARAM_READWRITE));
+
+	element_class->change_state = GST_DEBUG_FUNCPTR(gst_xavi_demux_change_state);
+}
+
+static void gst_xavi_demux_init(GstXAviDemux * xavi, GstXAviDemuxClass * klass)
+{
+	xavi->sinkpad = gst_pad_new_from_static_template(&sink_template, "sink");
+	gst_pad_set_activate_function(xavi->sinkpad, GST_DEBUG_FUNCPTR(gst_xavi_demux_sink_activate));
+	gst_pad_set_activatepull_function(xavi->sinkpad, GST_DEBUG_FUNCPTR(gst_xavi_demux_sink_activate_pull));
+	gst_element_add_pad(GST_ELEMENT(xavi), xavi->sinkpad);
+
+	xavi->window_size = DEFAULT_WINDOW_SIZE;
+	xavi->index = NULL;
+	xavi->keyframes = NULL;
+	xavi->window = NULL;
+	memset(xavi->streams, 0, sizeof(xavi->streams));
+	xavi->n_streams = 0;
+	gst_xavi_demux_reset(xavi);
+}
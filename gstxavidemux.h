@@ -0,0 +1,96 @@
+/*
+ * gstxavidemux.h - lightweight pull mode AVI demuxer
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#ifndef GSTXAVIDEMUX_H_
+#define GSTXAVIDEMUX_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_XAVI_DEMUX			(gst_xavi_demux_get_type())
+#define GST_XAVI_DEMUX(obj)			(G_TYPE_CHECK_INSTANCE_CAST((obj), GST_TYPE_XAVI_DEMUX, GstXAviDemux))
+#define GST_XAVI_DEMUX_CLASS(klass)	(G_TYPE_CHECK_CLASS_CAST((klass), GST_TYPE_XAVI_DEMUX, GstXAviDemuxClass))
+#define GST_IS_XAVI_DEMUX(obj)		(G_TYPE_CHECK_INSTANCE_TYPE((obj), GST_TYPE_XAVI_DEMUX))
+
+#define XAVI_MAX_STREAMS	8
+
+typedef struct _GstXAviDemux GstXAviDemux;
+typedef struct _GstXAviDemuxClass GstXAviDemuxClass;
+
+/* one chunk of the movi list, in file order */
+typedef struct {
+	guint64 offset;		/* absolute offset of the chunk data */
+	guint32 size;
+	guint32 count;		/* frames (or bytes for CBR audio) before this chunk */
+	guint8 stream;
+	guint8 keyframe;
+} xAviEntry;
+
+typedef struct {
+	GstPad * pad;
+	guint32 type;		/* vids, auds */
+	guint32 handler;
+	guint32 scale;
+	guint32 rate;
+	guint32 sample_size;
+	guint32 avg_bytes;	/* audio only, from the WAVEFORMATEX */
+	guint8 * strf;
+	guint strf_size;
+	guint8 * indx;		/* OpenDML super index */
+	guint indx_size;
+	guint64 total;		/* count at the end of the stream */
+	gboolean discont;
+	GstFlowReturn last_flow;
+} xAviStream;
+
+typedef enum {
+	XAVI_STATE_HEADER,
+	XAVI_STATE_DATA,
+} xAviState;
+
+struct _GstXAviDemux {
+	GstElement element;
+
+	GstPad * sinkpad;
+
+	xAviState state;
+	guint64 filesize;
+	guint64 movi_offset;	/* offset of the 'movi' fourcc */
+	guint64 movi_end;
+	guint64 idx1_offset;
+	guint32 idx1_size;
+
+	xAviStream streams[XAVI_MAX_STREAMS];
+	guint n_streams;
+	gint main_stream;		/* the one seeks are done on */
+
+	xAviEntry * index;
+	guint n_entries;
+	guint * keyframes;		/* positions in index of main stream keyframes */
+	guint n_keyframes;
+	guint cur;
+
+	/* the last region pulled from upstream, chunks are sub-buffers of it */
+	GstBuffer * window;
+	guint64 window_offset;
+	guint window_size;
+
+	GstSegment segment;
+	gboolean need_segment;
+	GstClockTime duration;
+};
+
+struct _GstXAviDemuxClass {
+	GstElementClass parent_class;
+};
+
+GType gst_xavi_demux_get_type(void);
+
+G_END_DECLS
+
+#endif /* GSTXAVIDEMUX_H_ */
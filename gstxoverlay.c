@@ -0,0 +1,367 @@
+/*
+ * gstxoverlay.c - cached text and logo overlay element
+ *
+ * In place on I420/YV12 frames. The text and the logo are rendered once
+ * on start, or right away when they change later on (see xoverlay.c), and
+ * every frame only gets the cached rectangle blended in. With nothing to
+ * draw the element is passthrough.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#include <string.h>
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+
+#include "gstxoverlay.h"
+#include "xconvert.h"
+
+enum {
+	PROP_0,
+	PROP_TEXT,
+	PROP_LOGO,
+	PROP_SCALE,
+	PROP_COLOR,
+	PROP_XPOS,
+	PROP_YPOS,
+	PROP_KERNELS,
+};
+
+#define DEFAULT_SCALE	2
+#define DEFAULT_COLOR	0xffffff
+#define DEFAULT_XPOS	16
+#define DEFAULT_YPOS	16
+#define DEFAULT_KERNELS	XBLEND_SSE2
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE("sink",
+		GST_PAD_SINK,
+		GST_PAD_ALWAYS,
+		GST_STATIC_CAPS("video/x-raw-yuv, "
+				"format = (fourcc) { I420, YV12 }, "
+				"width = (int) [ 1, MAX ], "
+				"height = (int) [ 1, MAX ], "
+				"framerate = (fraction) [ 0, MAX ]"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE("src",
+		GST_PAD_SRC,
+		GST_PAD_ALWAYS,
+		GST_STATIC_CAPS("video/x-raw-yuv, "
+				"format = (fourcc) { I420, YV12 }, "
+				"width = (int) [ 1, MAX ], "
+				"height = (int) [ 1, MAX ], "
+				"framerate = (fraction) [ 0, MAX ]"));
+
+#define GST_TYPE_XOVERLAY_KERNELS	(gst_xoverlay_kernels_get_type())
+static GType gst_xoverlay_kernels_get_type(void)
+{
+	static GType type = 0;
+	static const GEnumValue values[] = {
+		{ XBLEND_SCALAR, "Portable C", "scalar" },
+		{ XBLEND_SKIP, "Skip or copy a word at a time, blend bytewise, for ARMv5", "skip" },
+		{ XBLEND_SSE2, "SSE2", "sse2" },
+		{ 0, NULL, NULL },
+	};
+
+	if(!type)
+		type = g_enum_register_static("GstXOverlayKernels", values);
+
+	return type;
+}
+
+GST_BOILERPLATE(GstXOverlay, gst_xoverlay, GstBaseTransform, GST_TYPE_BASE_TRANSFORM);
+
+static void gst_xoverlay_base_init(gpointer g_class)
+{
+	GstElementClass * element_class = GST_ELEMENT_CLASS(g_class);
+
+	gst_element_class_add_pad_template(element_class, gst_static_pad_template_get(&sink_template));
+	gst_element_class_add_pad_template(element_class, gst_static_pad_template_get(&src_template));
+	gst_element_class_set_details_simple(element_class, "Cached text and logo overlay",
+			"Filter/Editor/Video",
+			"Blends pre-rendered text and a PAM logo into the video",
+			"xpucmo");
+}
+
+/*
+ * On start and after a content property changed. The logo is read from a
+ * file, so the rendering is done outside the lock the streaming thread
+ * blends under and only the result is swapped in.
+ */
+static void gst_xoverlay_render(GstXOverlay * xo)
+{
+	xOverlay ov, old;
+	gchar * text, * logo;
+	gint scale;
+	guint color, generation;
+	gboolean ok, current;
+
+	GST_OBJECT_LOCK(xo);
+	text = g_strdup(xo->text);
+	logo = g_strdup(xo->logo);
+	scale = xo->scale;
+	color = xo->color;
+	generation = ++xo->generation;
+	GST_OBJECT_UNLOCK(xo);
+
+	memset(&ov, 0, sizeof(xOverlay));
+	ok = xoverlay_render(&ov, text, logo, scale, color);
+	if(!ok)
+		GST_WARNING_OBJECT(xo, "logo %s not loaded", logo);
+
+	/* a later change is rendering as well, its result is the one to keep */
+	g_static_mutex_lock(&xo->render_lock);
+	GST_OBJECT_LOCK(xo);
+	current = generation == xo->generation;
+	if(current) {
+		old = xo->ov;
+		xo->ov = ov;
+	}
+	else {
+		old = ov;
+	}
+	GST_OBJECT_UNLOCK(xo);
+
+	/* takes the object lock itself, render_lock keeps a later swap from coming in between */
+	if(current)
+		gst_base_transform_set_passthrough(GST_BASE_TRANSFORM(xo), !ov.w);
+	g_static_mutex_unlock(&xo->render_lock);
+
+	xoverlay_free(&old);
+	g_free(text);
+	g_free(logo);
+}
+
+static void gst_xoverlay_set_property(GObject * object, guint prop_id, const GValue * value, GParamSpec * pspec)
+{
+	GstXOverlay * xo = GST_XOVERLAY(object);
+	gboolean render = FALSE;
+
+	GST_OBJECT_LOCK(xo);
+	switch(prop_id) {
+	case PROP_TEXT:
+		g_free(xo->text);
+		xo->text = g_value_dup_string(value);
+		break;
+	case PROP_LOGO:
+		g_free(xo->logo);
+		xo->logo = g_value_dup_string(value);
+		break;
+	case PROP_SCALE:
+		xo->scale = g_value_get_int(value);
+		break;
+	case PROP_COLOR:
+		xo->color = g_value_get_uint(value);
+		break;
+	case PROP_XPOS:
+		xo->xpos = g_value_get_int(value);
+		break;
+	case PROP_YPOS:
+		xo->ypos = g_value_get_int(value);
+		break;
+	case PROP_KERNELS:
+		xo->impl = g_value_get_enum(value);
+		xo->k = xblend_kernels_get(xo->impl);
+		if(!xo->k)
+			xo->k = xblend_kernels_best();
+		GST_INFO_OBJECT(xo, "using %s kernels", xo->k->name);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+		break;
+	}
+
+	switch(prop_id) {
+	case PROP_TEXT:
+	case PROP_LOGO:
+	case PROP_SCALE:
+	case PROP_COLOR:
+		/* several set at once before start are rendered together */
+		render = xo->started;
+		if(!render)
+			xo->dirty = TRUE;
+		break;
+	default:
+		break;
+	}
+	GST_OBJECT_UNLOCK(xo);
+
+	if(render)
+		gst_xoverlay_render(xo);
+}
+
+static void gst_xoverlay_get_property(GObject * object, guint prop_id, GValue * value, GParamSpec * pspec)
+{
+	GstXOverlay * xo = GST_XOVERLAY(object);
+
+	GST_OBJECT_LOCK(xo);
+	switch(prop_id) {
+	case PROP_TEXT:
+		g_value_set_string(value, xo->text);
+		break;
+	case PROP_LOGO:
+		g_value_set_string(value, xo->logo);
+		break;
+	case PROP_SCALE:
+		g_value_set_int(value, xo->scale);
+		break;
+	case PROP_COLOR:
+		g_value_set_uint(value, xo->color);
+		break;
+	case PROP_XPOS:
+		g_value_set_int(value, xo->xpos);
+		break;
+	case PROP_YPOS:
+		g_value_set_int(value, xo->ypos);
+		break;
+	case PROP_KERNELS:
+		g_value_set_enum(value, xo->impl);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+		break;
+	}
+	GST_OBJECT_UNLOCK(xo);
+}
+
+static gboolean gst_xoverlay_start(GstBaseTransform * trans)
+{
+	GstXOverlay * xo = GST_XOVERLAY(trans);
+	gboolean dirty;
+
+	GST_OBJECT_LOCK(xo);
+	xo->started = TRUE;
+	dirty = xo->dirty;
+	xo->dirty = FALSE;
+	GST_OBJECT_UNLOCK(xo);
+
+	if(dirty)
+		gst_xoverlay_render(xo);
+
+	return TRUE;
+}
+
+static gboolean gst_xoverlay_stop(GstBaseTransform * trans)
+{
+	GstXOverlay * xo = GST_XOVERLAY(trans);
+
+	/* the cache is kept, it is still good on the next start */
+	GST_OBJECT_LOCK(xo);
+	xo->started = FALSE;
+	GST_OBJECT_UNLOCK(xo);
+
+	return TRUE;
+}
+
+static gboolean gst_xoverlay_set_caps(GstBaseTransform * trans, GstCaps * incaps, GstCaps * outcaps)
+{
+	GstXOverlay * xo = GST_XOVERLAY(trans);
+	GstStructure * s = gst_caps_get_structure(incaps, 0);
+	guint32 fourcc;
+	gint width, height;
+
+	if(!gst_structure_get_fourcc(s, "format", &fourcc) ||
+			!gst_structure_get_int(s, "width", &width) || !gst_structure_get_int(s, "height", &height))
+		return FALSE;
+
+	GST_OBJECT_LOCK(xo);
+	xo->fourcc = fourcc;
+	xo->width = width;
+	xo->height = height;
+	GST_OBJECT_UNLOCK(xo);
+
+	return TRUE;
+}
+
+static GstFlowReturn gst_xoverlay_transform_ip(GstBaseTransform * trans, GstBuffer * buf)
+{
+	GstXOverlay * xo = GST_XOVERLAY(trans);
+	gint x, y;
+
+	/* the buffer was not made writable */
+	if(gst_base_transform_is_passthrough(trans))
+		return GST_FLOW_OK;
+
+	GST_OBJECT_LOCK(xo);
+	if(xo->ov.w && xo->fourcc && GST_BUFFER_SIZE(buf) >= xconv_input_size(xo->fourcc, xo->width, xo->height)) {
+		/* negative positions are from the right and bottom edges */
+		x = xo->xpos >= 0 ? xo->xpos : xo->width + xo->xpos + 1 - (xo->ov.bx + xo->ov.w);
+		y = xo->ypos >= 0 ? xo->ypos : xo->height + xo->ypos + 1 - (xo->ov.by + xo->ov.h);
+		xoverlay_blend(&xo->ov, xo->k, GST_BUFFER_DATA(buf), xo->fourcc, xo->width, xo->height, x, y);
+	}
+	GST_OBJECT_UNLOCK(xo);
+
+	return GST_FLOW_OK;
+}
+
+static void gst_xoverlay_finalize(GObject * object)
+{
+	GstXOverlay * xo = GST_XOVERLAY(object);
+
+	xoverlay_free(&xo->ov);
+	g_free(xo->text);
+	g_free(xo->logo);
+	g_static_mutex_free(&xo->render_lock);
+
+	G_OBJECT_CLASS(parent_class)->finalize(object);
+}
+
+static void gst_xoverlay_class_init(GstXOverlayClass * klass)
+{
+	GObjectClass * gobject_class = G_OBJECT_CLASS(klass);
+	GstBaseTransformClass * trans_class = GST_BASE_TRANSFORM_CLASS(klass);
+
+	gobject_class->set_property = gst_xoverlay_set_property;
+	gobject_class->get_property = gst_xoverlay_get_property;
+	gobject_class->finalize = gst_xoverlay_finalize;
+
+	g_object_class_install_property(gobject_class, PROP_TEXT,
+			g_param_spec_string("text", "Text", "Text to show, ASCII",
+					NULL, G_PARAM_READWRITE));
+	g_object_class_install_property(gobject_class, PROP_LOGO,
+			g_param_spec_string("logo", "Logo", "PAM image with alpha shown left of the text",
+					NULL, G_PARAM_READWRITE));
+	g_object_class_install_property(gobject_class, PROP_SCALE,
+			g_param_spec_int("scale", "Scale", "Font scale, the font is 8x8 pixels",
+					1, 8, DEFAULT_SCALE, G_PARAM_READWRITE));
+	g_object_class_install_property(gobject_class, PROP_COLOR,
+			g_param_spec_uint("color", "Color", "Text colour as 0xRRGGBB",
+					0, 0xffffff, DEFAULT_COLOR, G_PARAM_READWRITE));
+	g_object_class_install_property(gobject_class, PROP_XPOS,
+			g_param_spec_int("xpos", "X position", "Left edge of the overlay, negative places its right edge counting from the right of the frame",
+					G_MININT, G_MAXINT, DEFAULT_XPOS, G_PARAM_READWRITE));
+	g_object_class_install_property(gobject_class, PROP_YPOS,
+			g_param_spec_int("ypos", "Y position", "Top edge of the overlay, negative places its bottom edge counting from the bottom of the frame",
+					G_MININT, G_MAXINT, DEFAULT_YPOS, G_PARAM_READWRITE));
+	g_object_class_install_property(gobject_class, PROP_KERNELS,
+			g_param_spec_enum("kernels", "Kernels", "Preferred kernel set, falls back to the best the CPU supports",
+					GST_TYPE_XOVERLAY_KERNELS, DEFAULT_KERNELS, G_PARAM_READWRITE));
+
+	trans_class->start = GST_DEBUG_FUNCPTR(gst_xoverlay_start);
+	trans_class->stop = GST_DEBUG_FUNCPTR(gst_xoverlay_stop);
+	trans_class->set_caps = GST_DEBUG_FUNCPTR(gst_xoverlay_set_caps);
+	trans_class->transform_ip = GST_DEBUG_FUNCPTR(gst_xoverlay_transform_ip);
+}
+
+static void gst_xoverlay_init(GstXOverlay * xo, GstXOverlayClass * klass)
+{
+	xo->text = NULL;
+	xo->logo = NULL;
+	xo->scale = DEFAULT_SCALE;
+	xo->color = DEFAULT_COLOR;
+	xo->xpos = DEFAULT_XPOS;
+	xo->ypos = DEFAULT_YPOS;
+	xo->impl = DEFAULT_KERNELS;
+	xo->k = xblend_kernels_get(xo->impl);
+	if(!xo->k)
+		xo->k = xblend_kernels_best();
+	memset(&xo->ov, 0, sizeof(xOverlay));
+	xo->generation = 0;
+	xo->started = FALSE;
+	xo->dirty = FALSE;
+	g_static_mutex_init(&xo->render_lock);
+	xo->fourcc = 0;
+
+	/* nothing to draw yet */
+	gst_base_transform_set_passthrough(GST_BASE_TRANSFORM(xo), TRUE);
+}
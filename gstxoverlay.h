@@ -0,0 +1,60 @@
+/*
+ * gstxoverlay.h - cached text and logo overlay element
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#ifndef GSTXOVERLAY_H_
+#define GSTXOVERLAY_H_
+
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+
+#include "xoverlay.h"
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_XOVERLAY			(gst_xoverlay_get_type())
+#define GST_XOVERLAY(obj)			(G_TYPE_CHECK_INSTANCE_CAST((obj), GST_TYPE_XOVERLAY, GstXOverlay))
+#define GST_XOVERLAY_CLASS(klass)	(G_TYPE_CHECK_CLASS_CAST((klass), GST_TYPE_XOVERLAY, GstXOverlayClass))
+#define GST_IS_XOVERLAY(obj)		(G_TYPE_CHECK_INSTANCE_TYPE((obj), GST_TYPE_XOVERLAY))
+
+typedef struct _GstXOverlay GstXOverlay;
+typedef struct _GstXOverlayClass GstXOverlayClass;
+
+struct _GstXOverlay {
+	GstBaseTransform element;
+
+	/* properties, the content ones re-render the cache */
+	gchar * text;
+	gchar * logo;
+	gint scale;
+	guint color;
+	gint xpos;
+	gint ypos;
+	xBlendImpl impl;
+
+	/* object lock */
+	xOverlay ov;
+	guint generation;		/* of the last render started */
+	gboolean started;		/* content changes render right away */
+	gboolean dirty;			/* changed before start, rendered there once */
+	const xBlendKernels * k;
+
+	GStaticMutex render_lock;	/* swap and passthrough go together */
+
+	guint32 fourcc;
+	gint width;
+	gint height;
+};
+
+struct _GstXOverlayClass {
+	GstBaseTransformClass parent_class;
+};
+
+GType gst_xoverlay_get_type(void);
+
+G_END_DECLS
+
+#endif /* GSTXOVERLAY_H_ */
@@ -0,0 +1,276 @@
+/*
+ * gstxscale.c - colorspace convert and downscale element
+ *
+ * Converts I420/YV12/YUY2 decoder output to 32 bit BGRx and scales it with a
+ * bilinear filter, using the SIMD kernels from xconvert.c when the CPU has
+ * them. Meant for the display path when Xv is not available or the picture
+ * has to be fitted to the panel.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#include <string.h>
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+
+#include "gstxscale.h"
+
+enum {
+	PROP_0,
+	PROP_WIDTH,
+	PROP_HEIGHT,
+	PROP_KERNELS,
+};
+
+#define DEFAULT_KERNELS	XCONV_AVX2
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE("sink",
+		GST_PAD_SINK,
+		GST_PAD_ALWAYS,
+		GST_STATIC_CAPS("video/x-raw-yuv, "
+				"format = (fourcc) { I420, YV12, YUY2 }, "
+				"width = (int) [ 1, MAX ], "
+				"height = (int) [ 1, MAX ], "
+				"framerate = (fraction) [ 0, MAX ]"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE("src",
+		GST_PAD_SRC,
+		GST_PAD_ALWAYS,
+		GST_STATIC_CAPS("video/x-raw-rgb, "
+				"bpp = (int) 32, "
+				"depth = (int) 24, "
+				"endianness = (int) 4321, "
+				"red_mask = (int) 0x0000ff00, "
+				"green_mask = (int) 0x00ff0000, "
+				"blue_mask = (int) 0xff000000, "
+				"width = (int) [ 1, MAX ], "
+				"height = (int) [ 1, MAX ], "
+				"framerate = (fraction) [ 0, MAX ]"));
+
+#define GST_TYPE_XSCALE_KERNELS	(gst_xscale_kernels_get_type())
+static GType gst_xscale_kernels_get_type(void)
+{
+	static GType type = 0;
+	static const GEnumValue values[] = {
+		{ XCONV_SCALAR, "Portable C", "scalar" },
+		{ XCONV_SSE2, "SSE2", "sse2" },
+		{ XCONV_AVX2, "AVX2", "avx2" },
+		{ 0, NULL, NULL },
+	};
+
+	if(!type)
+		type = g_enum_register_static("GstXScaleKernels", values);
+
+	return type;
+}
+
+GST_BOILERPLATE(GstXScale, gst_xscale, GstBaseTransform, GST_TYPE_BASE_TRANSFORM);
+
+static void gst_xscale_base_init(gpointer g_class)
+{
+	GstElementClass * element_class = GST_ELEMENT_CLASS(g_class);
+
+	gst_element_class_add_pad_template(element_class, gst_static_pad_template_get(&sink_template));
+	gst_element_class_add_pad_template(element_class, gst_static_pad_template_get(&src_template));
+	gst_element_class_set_details_simple(element_class, "YUV to RGB convert and scale",
+			"Filter/Converter/Video/Scaler",
+			"Converts YUV to BGRx and scales it with SIMD kernels",
+			"xpucmo");
+}
+
+static void gst_xscale_set_property(GObject * object, guint prop_id, const GValue * value, GParamSpec * pspec)
+{
+	GstXScale * xs = GST_XSCALE(object);
+
+	switch(prop_id) {
+	case PROP_WIDTH:
+		xs->width = g_value_get_int(value);
+		break;
+	case PROP_HEIGHT:
+		xs->height = g_value_get_int(value);
+		break;
+	case PROP_KERNELS:
+		xs->impl = g_value_get_enum(value);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+		break;
+	}
+}
+
+static void gst_xscale_get_property(GObject * object, guint prop_id, GValue * value, GParamSpec * pspec)
+{
+	GstXScale * xs = GST_XSCALE(object);
+
+	switch(prop_id) {
+	case PROP_WIDTH:
+		g_value_set_int(value, xs->width);
+		break;
+	case PROP_HEIGHT:
+		g_value_set_int(value, xs->height);
+		break;
+	case PROP_KERNELS:
+		g_value_set_enum(value, xs->impl);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+		break;
+	}
+}
+
+static GstCaps * gst_xscale_transform_caps(GstBaseTransform * trans, GstPadDirection direction, GstCaps * caps)
+{
+	GstCaps * ret = gst_caps_new_empty();
+	guint i;
+
+	for(i = 0; i < gst_caps_get_size(caps); i++) {
+		GstStructure * s = gst_structure_copy(gst_caps_get_structure(caps, i));
+
+		gst_structure_remove_fields(s, "format", "bpp", "depth", "endianness",
+				"red_mask", "green_mask", "blue_mask", "pixel-aspect-ratio", NULL);
+		gst_structure_set(s, "width", GST_TYPE_INT_RANGE, 1, G_MAXINT,
+				"height", GST_TYPE_INT_RANGE, 1, G_MAXINT, NULL);
+
+		if(direction == GST_PAD_SINK) {
+			gst_structure_set_name(s, "video/x-raw-rgb");
+			gst_structure_set(s, "bpp", G_TYPE_INT, 32, "depth", G_TYPE_INT, 24,
+					"endianness", G_TYPE_INT, G_BIG_ENDIAN,
+					"red_mask", G_TYPE_INT, 0x0000ff00,
+					"green_mask", G_TYPE_INT, 0x00ff0000,
+					"blue_mask", G_TYPE_INT, 0xff000000, NULL);
+		}
+		else {
+			gst_structure_set_name(s, "video/x-raw-yuv");
+		}
+		gst_caps_append_structure(ret, s);
+	}
+
+	return ret;
+}
+
+static void gst_xscale_fixate_caps(GstBaseTransform * trans, GstPadDirection direction, GstCaps * caps, GstCaps * othercaps)
+{
+	GstXScale * xs = GST_XSCALE(trans);
+	GstStructure * ins, * outs;
+	gint width = 0, height = 0;
+
+	/* only the output size is ours to choose */
+	if(direction != GST_PAD_SINK || gst_caps_is_empty(othercaps))
+		return;
+
+	ins = gst_caps_get_structure(caps, 0);
+	outs = gst_caps_get_structure(othercaps, 0);
+	gst_structure_get_int(ins, "width", &width);
+	gst_structure_get_int(ins, "height", &height);
+
+	gst_structure_fixate_field_nearest_int(outs, "width", xs->width ? xs->width : width);
+	gst_structure_fixate_field_nearest_int(outs, "height", xs->height ? xs->height : height);
+}
+
+static gboolean gst_xscale_get_unit_size(GstBaseTransform * trans, GstCaps * caps, guint * size)
+{
+	GstStructure * s = gst_caps_get_structure(caps, 0);
+	gint width, height;
+	guint32 fourcc;
+
+	if(!gst_structure_get_int(s, "width", &width) || !gst_structure_get_int(s, "height", &height))
+		return FALSE;
+
+	if(gst_structure_has_name(s, "video/x-raw-rgb")) {
+		*size = width * height * 4;
+		return TRUE;
+	}
+
+	if(!gst_structure_get_fourcc(s, "format", &fourcc))
+		return FALSE;
+
+	*size = xconv_input_size(fourcc, width, height);
+
+	return *size != 0;
+}
+
+static gboolean gst_xscale_set_caps(GstBaseTransform * trans, GstCaps * incaps, GstCaps * outcaps)
+{
+	GstXScale * xs = GST_XSCALE(trans);
+	GstStructure * ins = gst_caps_get_structure(incaps, 0);
+	GstStructure * outs = gst_caps_get_structure(outcaps, 0);
+	const xConvKernels * k;
+	gint in_w, in_h, out_w, out_h;
+	guint32 fourcc;
+
+	if(!gst_structure_get_fourcc(ins, "format", &fourcc) ||
+			!gst_structure_get_int(ins, "width", &in_w) || !gst_structure_get_int(ins, "height", &in_h) ||
+			!gst_structure_get_int(outs, "width", &out_w) || !gst_structure_get_int(outs, "height", &out_h))
+		return FALSE;
+
+	k = xconv_kernels_get(xs->impl);
+	if(!k)
+		k = xconv_kernels_best();
+
+	GST_INFO_OBJECT(xs, "%" GST_FOURCC_FORMAT " %dx%d -> BGRx %dx%d using %s kernels",
+			GST_FOURCC_ARGS(fourcc), in_w, in_h, out_w, out_h, k->name);
+
+	return xconv_setup(&xs->conv, k, fourcc, in_w, in_h, out_w, out_h);
+}
+
+static GstFlowReturn gst_xscale_transform(GstBaseTransform * trans, GstBuffer * inbuf, GstBuffer * outbuf)
+{
+	GstXScale * xs = GST_XSCALE(trans);
+
+	if(!xs->conv.k)
+		return GST_FLOW_NOT_NEGOTIATED;
+
+	xconv_frame(&xs->conv, GST_BUFFER_DATA(inbuf), GST_BUFFER_DATA(outbuf));
+
+	return GST_FLOW_OK;
+}
+
+static gboolean gst_xscale_stop(GstBaseTransform * trans)
+{
+	xconv_free(&GST_XSCALE(trans)->conv);
+
+	return TRUE;
+}
+
+static void gst_xscale_finalize(GObject * object)
+{
+	xconv_free(&GST_XSCALE(object)->conv);
+
+	G_OBJECT_CLASS(parent_class)->finalize(object);
+}
+
+static void gst_xscale_class_init(GstXScaleClass * klass)
+{
+	GObjectClass * gobject_class = G_OBJECT_CLASS(klass);
+	GstBaseTransformClass * trans_class = GST_BASE_TRANSFORM_CLASS(klass);
+
+	gobject_class->set_property = gst_xscale_set_property;
+	gobject_class->get_property = gst_xscale_get_property;
+	gobject_class->finalize = gst_xscale_finalize;
+
+	g_object_class_install_property(gobject_class, PROP_WIDTH,
+			g_param_spec_int("width", "Width", "Output width, 0 keeps the input width",
+					0, G_MAXINT, 0, G_PARAM_READWRITE));
+	g_object_class_install_property(gobject_class, PROP_HEIGHT,
+			g_param_spec_int("height", "Height", "Output height, 0 keeps the input height",
+					0, G_MAXINT, 0, G_PARAM_READWRITE));
+	g_object_class_install_property(gobject_class, PROP_KERNELS,
+			g_param_spec_enum("kernels", "Kernels", "Preferred kernel set, falls back to the best the CPU supports",
+					GST_TYPE_XSCALE_KERNELS, DEFAULT_KERNELS, G_PARAM_READWRITE));
+
+	trans_class->transform_caps = GST_DEBUG_FUNCPTR(gst_xscale_transform_caps);
+	trans_class->fixate_caps = GST_DEBUG_FUNCPTR(gst_xscale_fixate_caps);
+	trans_class->get_unit_size = GST_DEBUG_FUNCPTR(gst_xscale_get_unit_size);
+	trans_class->set_caps = GST_DEBUG_FUNCPTR(gst_xscale_set_caps);
+	trans_class->transform = GST_DEBUG_FUNCPTR(gst_xscale_transform);
+	trans_class->stop = GST_DEBUG_FUNCPTR(gst_xscale_stop);
+}
+
+static void gst_xscale_init(GstXScale * xs, GstXScaleClass * klass)
+{
+	xs->width = 0;
+	xs->height = 0;
+	xs->impl = DEFAULT_KERNELS;
+	memset(&xs->conv, 0, sizeof(xConvContext));
+}
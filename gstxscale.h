@@ -0,0 +1,45 @@
+/*
+ * gstxscale.h - colorspace convert and downscale element
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#ifndef GSTXSCALE_H_
+#define GSTXSCALE_H_
+
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+
+#include "xconvert.h"
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_XSCALE				(gst_xscale_get_type())
+#define GST_XSCALE(obj)				(G_TYPE_CHECK_INSTANCE_CAST((obj), GST_TYPE_XSCALE, GstXScale))
+#define GST_XSCALE_CLASS(klass)		(G_TYPE_CHECK_CLASS_CAST((klass), GST_TYPE_XSCALE, GstXScaleClass))
+#define GST_IS_XSCALE(obj)			(G_TYPE_CHECK_INSTANCE_TYPE((obj), GST_TYPE_XSCALE))
+
+typedef struct _GstXScale GstXScale;
+typedef struct _GstXScaleClass GstXScaleClass;
+
+struct _GstXScale {
+	GstBaseTransform element;
+
+	/* properties, 0 keeps the input size */
+	gint width;
+	gint height;
+	xConvImpl impl;
+
+	xConvContext conv;
+};
+
+struct _GstXScaleClass {
+	GstBaseTransformClass parent_class;
+};
+
+GType gst_xscale_get_type(void);
+
+G_END_DECLS
+
+#endif /* GSTXSCALE_H_ */
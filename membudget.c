@@ -0,0 +1,362 @@
+/*
+ * membudget.c - global memory budget for the player pipeline
+ *
+ * The configured total is divided among the source blocks in flight, the
+ * queues and the decoder frame pool. A frame cache for looping is taken out
+ * of the total first and the split shares what it leaves. The limits are
+ * applied to the element properties once the pipeline is built, and a
+ * periodic poll tracks the actual use per component, tightening the queues
+ * when the sum goes over the total. The process RSS growth since the
+ * pipeline was built is checked against the total as well, going over it
+ * also shrinks the xavidemux pull window.
+ *
+ * The decoder pool is only estimated from the negotiated caps and the
+ * decoder allocates it itself, so for that part the budget is advisory: it
+ * is reported, and the queues and the window give way for it.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <gst/gst.h>
+#include <glib.h>
+
+#include "membudget.h"
+
+#define MEM_POLL_INTERVAL	250		/* ms */
+#define MEM_MIN_BLOCKSIZE	4096
+#define MEM_MIN_QUEUE		(64 * 1024)
+#define MEM_MIN_TOTAL		(1024 * 1024)
+#define DECODER_POOL_FRAMES	4		/* reference + output frames held by the decoder */
+
+/* share of the total budget, in percent */
+static const guint mem_share[MEM_COMP_COUNT] = {
+	[MEM_COMP_SOURCE]		= 20,
+	[MEM_COMP_VIDEO_QUEUE]	= 25,
+	[MEM_COMP_AUDIO_QUEUE]	= 10,
+	[MEM_COMP_DECODER]		= 45,
+	[MEM_COMP_FRAME_CACHE]	= 0,
+};
+
+static const gchar * mem_name[MEM_COMP_COUNT] = {
+	[MEM_COMP_SOURCE]		= "source",
+	[MEM_COMP_VIDEO_QUEUE]	= "video queue",
+	[MEM_COMP_AUDIO_QUEUE]	= "audio queue",
+	[MEM_COMP_DECODER]		= "decoder pool",
+	[MEM_COMP_FRAME_CACHE]	= "frame cache",
+};
+
+static void account_set(xMemAccount * acc, gint value)
+{
+	gint peak;
+
+	g_atomic_int_set(&acc->current, value);
+	do {
+		peak = g_atomic_int_get(&acc->peak);
+		if(value <= peak)
+			break;
+	} while(!g_atomic_int_compare_and_exchange(&acc->peak, peak, value));
+}
+
+/* the fixed split shares what the frame cache leaves */
+static void split(xMemBudget * budget)
+{
+	guint rest = budget->total - MIN(budget->comp[MEM_COMP_FRAME_CACHE].limit, budget->total);
+	gint i;
+
+	for(i = 0; i < MEM_COMP_COUNT; i++) {
+		if(i != MEM_COMP_FRAME_CACHE)
+			budget->comp[i].limit = (guint) ((guint64) rest * mem_share[i] / 100);
+	}
+}
+
+static void clamp_elements(xMemBudget * budget);
+
+/* for the components outside the fixed split, the others get less */
+void mem_budget_set_limit(xMemBudget * budget, xMemComponent comp, guint limit)
+{
+	budget->comp[comp].limit = limit;
+	split(budget);
+	if(budget->PipeLine)
+		clamp_elements(budget);
+}
+
+void mem_budget_charge(xMemBudget * budget, xMemComponent comp, gint bytes)
+{
+	xMemAccount * acc = &budget->comp[comp];
+
+	account_set(acc, g_atomic_int_get(&acc->current) + bytes);
+	if(bytes > 0 && (guint) g_atomic_int_get(&acc->current) > acc->limit)
+		g_print("Memory budget: %s over limit (%d > %u bytes)\n", mem_name[comp], acc->current, acc->limit);
+}
+
+void mem_budget_init(xMemBudget * budget, guint total)
+{
+	memset(budget, 0, sizeof(xMemBudget));
+	budget->total = MAX(total, MEM_MIN_TOTAL);
+	split(budget);
+}
+
+static gboolean source_probe(GstPad * pad, GstBuffer * buffer, void * data)
+{
+	xMemBudget * budget = (xMemBudget *) data;
+
+	/* the block being parsed downstream plus the one being read */
+	account_set(&budget->comp[MEM_COMP_SOURCE], GST_BUFFER_SIZE(buffer) * 2);
+
+	return TRUE;
+}
+
+static void decoder_caps_notify(GObject * object, GParamSpec * pspec, void * data)
+{
+	xMemBudget * budget = (xMemBudget *) data;
+	GstCaps * caps = gst_pad_get_negotiated_caps(GST_PAD(object));
+	GstStructure * s;
+	gint width = 0, height = 0, bpp = 12;
+	gint pool;
+
+	if(!caps)
+		return;
+
+	s = gst_caps_get_structure(caps, 0);
+	gst_structure_get_int(s, "width", &width);
+	gst_structure_get_int(s, "height", &height);
+	if(gst_structure_has_name(s, "video/x-raw-rgb"))
+		gst_structure_get_int(s, "bpp", &bpp);
+	gst_caps_unref(caps);
+
+	pool = width * height * bpp / 8 * DECODER_POOL_FRAMES;
+	account_set(&budget->comp[MEM_COMP_DECODER], pool);
+
+	if((guint) pool > budget->comp[MEM_COMP_DECODER].limit)
+		g_print("Memory budget: decoder pool %dx%d needs %d bytes, over limit %u\n", width, height, pool, budget->comp[MEM_COMP_DECODER].limit);
+}
+
+static void clamp_queue(GstElement * queue, guint limit)
+{
+	guint bytes;
+
+	if(!queue)
+		return;
+
+	/* 0 means unbounded, never write it */
+	limit = MAX(limit, MEM_MIN_QUEUE);
+	g_object_get(G_OBJECT(queue), "max-size-bytes", &bytes, NULL);
+	if(bytes == 0 || bytes > limit)
+		g_object_set(G_OBJECT(queue), "max-size-bytes", limit, NULL);
+}
+
+/* down to their share, again when the frame cache takes its part */
+static void clamp_elements(xMemBudget * budget)
+{
+	guint limit = budget->comp[MEM_COMP_SOURCE].limit;
+
+	/* xavidemux pulls a window of its own size, the filesrc blocksize does not apply */
+	if(budget->Demuxer) {
+		guint window;
+
+		g_object_get(G_OBJECT(budget->Demuxer), "window-size", &window, NULL);
+		if(window * 2 > limit) {
+			window = MAX(limit / 2, MEM_MIN_BLOCKSIZE);
+			g_object_set(G_OBJECT(budget->Demuxer), "window-size", window, NULL);
+		}
+		/* the window being cut up, and the last one until its chunks are gone */
+		account_set(&budget->comp[MEM_COMP_SOURCE], window * 2);
+	}
+
+	if(budget->Source) {
+		guint blocksize;
+
+		g_object_get(G_OBJECT(budget->Source), "blocksize", &blocksize, NULL);
+		if(blocksize * 2 > limit) {
+			blocksize = MAX(limit / 2, MEM_MIN_BLOCKSIZE);
+			g_object_set(G_OBJECT(budget->Source), "blocksize", blocksize, NULL);
+		}
+	}
+
+	clamp_queue(budget->VideoQueue, budget->comp[MEM_COMP_VIDEO_QUEUE].limit);
+	clamp_queue(budget->AudioQueue, budget->comp[MEM_COMP_AUDIO_QUEUE].limit);
+}
+
+void mem_budget_apply(xMemBudget * budget, GstElement * PipeLine, GMainContext * context)
+{
+	GstElement * Decoder;
+	GstPad * pad;
+
+	budget->PipeLine = GST_ELEMENT(gst_object_ref(GST_OBJECT(PipeLine)));
+	budget->Source = gst_bin_get_by_name(GST_BIN(PipeLine), "source");
+	budget->VideoQueue = gst_bin_get_by_name(GST_BIN(PipeLine), "video_queue0");
+	budget->AudioQueue = gst_bin_get_by_name(GST_BIN(PipeLine), "audio_queue0");
+	Decoder = gst_bin_get_by_name(GST_BIN(PipeLine), "video_decoder");
+
+	budget->Demuxer = gst_bin_get_by_name(GST_BIN(PipeLine), "avi_demuxer");
+	if(budget->Demuxer && !g_object_class_find_property(G_OBJECT_GET_CLASS(budget->Demuxer), "window-size")) {
+		gst_object_unref(GST_OBJECT(budget->Demuxer));
+		budget->Demuxer = NULL;
+	}
+
+	clamp_elements(budget);
+
+	if(budget->Source) {
+		pad = gst_element_get_static_pad(budget->Source, "src");
+		gst_pad_add_buffer_probe(pad, G_CALLBACK(source_probe), budget);
+		gst_object_unref(GST_OBJECT(pad));
+	}
+
+	if(Decoder) {
+		pad = gst_element_get_static_pad(Decoder, "src");
+		if(pad) {
+			g_signal_connect(pad, "notify::caps", G_CALLBACK(decoder_caps_notify), budget);
+			gst_object_unref(GST_OBJECT(pad));
+		}
+		gst_object_unref(GST_OBJECT(Decoder));
+	}
+
+	/* what the process holds without the pipeline running */
+	budget->rss_base = mem_budget_read_rss();
+
+	/* on the context of whoever drives the pipeline, NULL is the default one */
+	budget->poll = g_timeout_source_new(MEM_POLL_INTERVAL);
+	g_source_set_callback(budget->poll, (GSourceFunc) mem_budget_poll, budget, NULL);
+	g_source_attach(budget->poll, context);
+}
+
+guint64 mem_budget_read_rss(void)
+{
+	FILE * f = fopen("/proc/self/statm", "r");
+	unsigned long size, rss = 0;
+
+	if(!f)
+		return 0;
+	if(fscanf(f, "%lu %lu", &size, &rss) != 2)
+		rss = 0;
+	fclose(f);
+
+	return (guint64) rss * sysconf(_SC_PAGESIZE);
+}
+
+static void sample_queue(xMemBudget * budget, xMemComponent comp, GstElement * queue)
+{
+	guint level;
+
+	if(!queue)
+		return;
+
+	g_object_get(G_OBJECT(queue), "current-level-bytes", &level, NULL);
+	account_set(&budget->comp[comp], level);
+}
+
+/* take the overshoot out of the queues, they are the only elastic part */
+static void shrink_queue(xMemBudget * budget, xMemComponent comp, GstElement * queue, guint cut)
+{
+	xMemAccount * acc = &budget->comp[comp];
+
+	if(!queue || acc->limit <= MEM_MIN_QUEUE)
+		return;
+
+	acc->limit = MAX(acc->limit > cut ? acc->limit - cut : 0, MEM_MIN_QUEUE);
+	g_object_set(G_OBJECT(queue), "max-size-bytes", acc->limit, NULL);
+	g_print("Memory budget: %s limit lowered to %u bytes\n", mem_name[comp], acc->limit);
+}
+
+/* halve the pull window, it is what the RSS can still be taken out of */
+static void shrink_window(xMemBudget * budget)
+{
+	guint window;
+
+	if(!budget->Demuxer)
+		return;
+
+	g_object_get(G_OBJECT(budget->Demuxer), "window-size", &window, NULL);
+	if(window <= MEM_MIN_BLOCKSIZE)
+		return;
+
+	window = MAX(window / 2, MEM_MIN_BLOCKSIZE);
+	g_object_set(G_OBJECT(budget->Demuxer), "window-size", window, NULL);
+	account_set(&budget->comp[MEM_COMP_SOURCE], window * 2);
+	g_print("Memory budget: demuxer window lowered to %u bytes\n", window);
+}
+
+gboolean mem_budget_poll(xMemBudget * budget)
+{
+	guint64 rss, rss_over = 0;
+	guint used = 0, over = 0;
+	gint i;
+
+	/* the audio branch is built from the demuxer caps, after apply */
+	if(!budget->AudioQueue) {
+		budget->AudioQueue = gst_bin_get_by_name(GST_BIN(budget->PipeLine), "audio_queue0");
+		clamp_queue(budget->AudioQueue, budget->comp[MEM_COMP_AUDIO_QUEUE].limit);
+	}
+
+	sample_queue(budget, MEM_COMP_VIDEO_QUEUE, budget->VideoQueue);
+	sample_queue(budget, MEM_COMP_AUDIO_QUEUE, budget->AudioQueue);
+
+	rss = mem_budget_read_rss();
+	if(rss > budget->rss_peak)
+		budget->rss_peak = rss;
+	if(rss > budget->rss_base + budget->total)
+		rss_over = rss - budget->rss_base - budget->total;
+
+	for(i = 0; i < MEM_COMP_COUNT; i++)
+		used += g_atomic_int_get(&budget->comp[i].current);
+	if(used > budget->total)
+		over = used - budget->total;
+	/* the estimates missed something, the process is what gets killed */
+	if(rss_over > over)
+		over = (guint) MIN(rss_over, (guint64) G_MAXUINT);
+
+	if(over) {
+		budget->over_count++;
+		shrink_queue(budget, MEM_COMP_VIDEO_QUEUE, budget->VideoQueue, over / 2);
+		shrink_queue(budget, MEM_COMP_AUDIO_QUEUE, budget->AudioQueue, over - over / 2);
+		if(rss_over)
+			shrink_window(budget);
+	}
+
+	/* call me again */
+	return TRUE;
+}
+
+void mem_budget_report(xMemBudget * budget)
+{
+	gint i;
+
+	g_print("Memory budget: %u bytes total, exceeded %u times\n", budget->total, budget->over_count);
+	for(i = 0; i < MEM_COMP_COUNT; i++) {
+		g_print("%16s: peak %10d / limit %10u\n", mem_name[i], budget->comp[i].peak, budget->comp[i].limit);
+	}
+	g_print("%16s: peak %10" G_GUINT64_FORMAT " / base %10" G_GUINT64_FORMAT "\n", "process rss", budget->rss_peak, budget->rss_base);
+}
+
+void mem_budget_release(xMemBudget * budget)
+{
+	if(budget->poll) {
+		g_source_destroy(budget->poll);
+		g_source_unref(budget->poll);
+		budget->poll = NULL;
+	}
+	if(budget->PipeLine) {
+		gst_object_unref(GST_OBJECT(budget->PipeLine));
+		budget->PipeLine = NULL;
+	}
+	if(budget->Source) {
+		gst_object_unref(GST_OBJECT(budget->Source));
+		budget->Source = NULL;
+	}
+	if(budget->Demuxer) {
+		gst_object_unref(GST_OBJECT(budget->Demuxer));
+		budget->Demuxer = NULL;
+	}
+	if(budget->VideoQueue) {
+		gst_object_unref(GST_OBJECT(budget->VideoQueue));
+		budget->VideoQueue = NULL;
+	}
+	if(budget->AudioQueue) {
+		gst_object_unref(GST_OBJECT(budget->AudioQueue));
+		budget->AudioQueue = NULL;
+	}
+}
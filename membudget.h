@@ -0,0 +1,58 @@
+/*
+ * membudget.h - global memory budget for the player pipeline
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#ifndef MEMBUDGET_H_
+#define MEMBUDGET_H_
+
+#include <gst/gst.h>
+#include <glib.h>
+
+#ifdef MACH_IMX27
+#define MEM_BUDGET_DEFAULT	(16 * 1024 * 1024)	/* 64 MB boards */
+#else
+#define MEM_BUDGET_DEFAULT	(64 * 1024 * 1024)
+#endif
+
+typedef enum {
+	MEM_COMP_SOURCE,		/* filesrc blocks or the demuxer pull window in flight */
+	MEM_COMP_VIDEO_QUEUE,
+	MEM_COMP_AUDIO_QUEUE,
+	MEM_COMP_DECODER,		/* decoder frame pool (estimated from caps) */
+	MEM_COMP_FRAME_CACHE,	/* decoded frames kept for looping, limit set by the user */
+	MEM_COMP_COUNT
+} xMemComponent;
+
+typedef struct {
+	guint limit;
+	volatile gint current;
+	volatile gint peak;
+} xMemAccount;
+
+typedef struct {
+	guint total;
+	xMemAccount comp[MEM_COMP_COUNT];
+	GstElement * PipeLine;
+	GstElement * Source;
+	GstElement * Demuxer;		/* only when it has a pull window */
+	GstElement * VideoQueue;
+	GstElement * AudioQueue;
+	guint over_count;
+	guint64 rss_base;			/* at apply, the growth over it counts */
+	guint64 rss_peak;
+	GSource * poll;
+} xMemBudget;
+
+void mem_budget_init(xMemBudget * budget, guint total);
+void mem_budget_apply(xMemBudget * budget, GstElement * PipeLine, GMainContext * context);
+void mem_budget_set_limit(xMemBudget * budget, xMemComponent comp, guint limit);
+void mem_budget_charge(xMemBudget * budget, xMemComponent comp, gint bytes);
+gboolean mem_budget_poll(xMemBudget * budget);
+guint64 mem_budget_read_rss(void);
+void mem_budget_report(xMemBudget * budget);
+void mem_budget_release(xMemBudget * budget);
+
+#endif /* MEMBUDGET_H_ */
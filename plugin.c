@@ -0,0 +1,37 @@
+/*
+ * plugin.c - in-tree elements
+ *
+ * Registers the project's own elements as a static plugin so they can be
+ * created by name like any installed one.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#include <gst/gst.h>
+
+#include "plugin.h"
+#include "gstxscale.h"
+#include "gstxavidemux.h"
+#include "gstxoverlay.h"
+
+static gboolean plugin_init(GstPlugin * plugin)
+{
+	if(!gst_element_register(plugin, "xscale", GST_RANK_NONE, GST_TYPE_XSCALE))
+		return FALSE;
+
+	if(!gst_element_register(plugin, "xavidemux", GST_RANK_NONE, GST_TYPE_XAVI_DEMUX))
+		return FALSE;
+
+	if(!gst_element_register(plugin, "xoverlay", GST_RANK_NONE, GST_TYPE_XOVERLAY))
+		return FALSE;
+
+	return TRUE;
+}
+
+gboolean asisbg_plugin_register(void)
+{
+	return gst_plugin_register_static(GST_VERSION_MAJOR, GST_VERSION_MINOR,
+			"asisbg", "Asis-BG in-tree elements", plugin_init,
+			"0.1", "LGPL", "gst-play", "gst-play", "Asis-BG");
+}
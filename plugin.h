@@ -0,0 +1,15 @@
+/*
+ * plugin.h - in-tree elements
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#ifndef PLUGIN_H_
+#define PLUGIN_H_
+
+#include <gst/gst.h>
+
+gboolean asisbg_plugin_register(void);
+
+#endif /* PLUGIN_H_ */
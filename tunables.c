@@ -0,0 +1,173 @@
+/*
+ * tunables.c - pipeline tunables and the per-platform profile
+ *
+ * The defaults are the values the player always used. A profile written by
+ * the autotuner (or by hand) overrides them key by key, missing keys keep
+ * the default, so an old profile stays usable when tunables are added.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "tunables.h"
+#include "xqos.h"
+
+void tune_defaults(xTunables * tune)
+{
+	tune->video_queue_buffers = 2;
+	tune->video_queue_bytes = 400;
+	tune->video_queue_time = 400;
+	tune->source_blocksize = 1600000;
+	tune->demuxer_window = 256 * 1024;
+#ifdef MACH_IMX27
+	tune->sink_sync = FALSE;
+#else
+	tune->sink_sync = TRUE;
+#endif
+	tune->max_lateness = XQOS_MAX_LATENESS;
+	tune->display_width = SCR_W;
+	tune->display_height = SCR_H;
+}
+
+gchar * tune_profile_path(void)
+{
+	return g_build_filename(g_get_user_config_dir(), "asisbg", "player-" TUNE_PLATFORM ".conf", NULL);
+}
+
+/* only touches *value when the key is there */
+static gboolean get_int(GKeyFile * kf, const gchar * key, gint * value, GError ** error)
+{
+	GError * err = NULL;
+	gint v;
+
+	if(!g_key_file_has_key(kf, TUNE_GROUP, key, NULL))
+		return TRUE;
+
+	v = g_key_file_get_integer(kf, TUNE_GROUP, key, &err);
+	if(err) {
+		g_propagate_error(error, err);
+		return FALSE;
+	}
+	*value = v;
+
+	return TRUE;
+}
+
+static gboolean get_int64(GKeyFile * kf, const gchar * key, gint64 * value, GError ** error)
+{
+	gchar * str, * end;
+	gint64 v;
+
+	if(!g_key_file_has_key(kf, TUNE_GROUP, key, NULL))
+		return TRUE;
+
+	/* no 64 bit getter in this GLib */
+	str = g_key_file_get_value(kf, TUNE_GROUP, key, error);
+	if(!str)
+		return FALSE;
+	v = g_ascii_strtoll(str, &end, 10);
+	if(end == str || *end) {
+		g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE, "Key %s has invalid value %s", key, str);
+		g_free(str);
+		return FALSE;
+	}
+	g_free(str);
+	*value = v;
+
+	return TRUE;
+}
+
+gboolean tune_load(xTunables * tune, const gchar * path, GError ** error)
+{
+	GKeyFile * kf = g_key_file_new();
+	xTunables t = *tune;
+	gint64 queue_time = t.video_queue_time;
+	gint buffers = t.video_queue_buffers, bytes = t.video_queue_bytes, blocksize = t.source_blocksize;
+	gint window = t.demuxer_window;
+	gboolean ret = FALSE;
+	GError * err = NULL;
+
+	if(!g_key_file_load_from_file(kf, path, G_KEY_FILE_NONE, error))
+		goto out;
+
+	if(!(get_int(kf, "video-queue-buffers", &buffers, error) &&
+			get_int(kf, "video-queue-bytes", &bytes, error) &&
+			get_int64(kf, "video-queue-time", &queue_time, error) &&
+			get_int(kf, "source-blocksize", &blocksize, error) &&
+			get_int(kf, "demuxer-window", &window, error) &&
+			get_int64(kf, "max-lateness", &t.max_lateness, error) &&
+			get_int(kf, "display-width", &t.display_width, error) &&
+			get_int(kf, "display-height", &t.display_height, error)))
+		goto out;
+
+	if(g_key_file_has_key(kf, TUNE_GROUP, "sink-sync", NULL)) {
+		t.sink_sync = g_key_file_get_boolean(kf, TUNE_GROUP, "sink-sync", &err);
+		if(err) {
+			g_propagate_error(error, err);
+			goto out;
+		}
+	}
+
+	if(buffers < 0 || bytes < 0 || queue_time < 0 || blocksize <= 0 || window < 4096 || t.display_width <= 0 || t.display_height <= 0) {
+		g_set_error(error, G_KEY_FILE_ERROR, G_KEY_FILE_ERROR_INVALID_VALUE, "%s: value out of range", path);
+		goto out;
+	}
+
+	t.video_queue_buffers = buffers;
+	t.video_queue_bytes = bytes;
+	t.video_queue_time = queue_time;
+	t.source_blocksize = blocksize;
+	t.demuxer_window = window;
+	*tune = t;
+	ret = TRUE;
+
+out:
+	g_key_file_free(kf);
+
+	return ret;
+}
+
+void tune_to_keyfile(const xTunables * tune, GKeyFile * kf)
+{
+	gchar * str;
+
+	g_key_file_set_integer(kf, TUNE_GROUP, "video-queue-buffers", tune->video_queue_buffers);
+	g_key_file_set_integer(kf, TUNE_GROUP, "video-queue-bytes", tune->video_queue_bytes);
+	str = g_strdup_printf("%" G_GUINT64_FORMAT, tune->video_queue_time);
+	g_key_file_set_value(kf, TUNE_GROUP, "video-queue-time", str);
+	g_free(str);
+	g_key_file_set_integer(kf, TUNE_GROUP, "source-blocksize", tune->source_blocksize);
+	g_key_file_set_integer(kf, TUNE_GROUP, "demuxer-window", tune->demuxer_window);
+	g_key_file_set_boolean(kf, TUNE_GROUP, "sink-sync", tune->sink_sync);
+	str = g_strdup_printf("%" G_GINT64_FORMAT, tune->max_lateness);
+	g_key_file_set_value(kf, TUNE_GROUP, "max-lateness", str);
+	g_free(str);
+	g_key_file_set_integer(kf, TUNE_GROUP, "display-width", tune->display_width);
+	g_key_file_set_integer(kf, TUNE_GROUP, "display-height", tune->display_height);
+}
+
+gboolean tune_save_keyfile(GKeyFile * kf, const gchar * path, GError ** error)
+{
+	gchar * dir = g_path_get_dirname(path);
+	gchar * data;
+	gsize len;
+	gboolean ret;
+
+	if(g_mkdir_with_parents(dir, 0755) < 0) {
+		g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno), "Cannot create %s", dir);
+		g_free(dir);
+		return FALSE;
+	}
+	g_free(dir);
+
+	data = g_key_file_to_data(kf, &len, NULL);
+	ret = g_file_set_contents(path, data, len, error);
+	g_free(data);
+
+	return ret;
+}
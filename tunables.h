@@ -0,0 +1,43 @@
+/*
+ * tunables.h - pipeline tunables and the per-platform profile
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#ifndef TUNABLES_H_
+#define TUNABLES_H_
+
+#include <gst/gst.h>
+#include <glib.h>
+
+#define SCR_W	800
+#define SCR_H	480
+
+#ifdef MACH_IMX27
+#define TUNE_PLATFORM	"imx27"
+#else
+#define TUNE_PLATFORM	"x86"
+#endif
+
+#define TUNE_GROUP		"player"
+
+typedef struct {
+	guint video_queue_buffers;
+	guint video_queue_bytes;
+	guint64 video_queue_time;	/* ns */
+	guint source_blocksize;		/* filesrc, only read by push mode demuxers like avidemux */
+	guint demuxer_window;		/* xavidemux window-size, its pull size */
+	gboolean sink_sync;
+	gint64 max_lateness;		/* ns, -1 never drops in the sink */
+	gint display_width;
+	gint display_height;
+} xTunables;
+
+void tune_defaults(xTunables * tune);
+gchar * tune_profile_path(void);
+gboolean tune_load(xTunables * tune, const gchar * path, GError ** error);
+void tune_to_keyfile(const xTunables * tune, GKeyFile * kf);
+gboolean tune_save_keyfile(GKeyFile * kf, const gchar * path, GError ** error);
+
+#endif /* TUNABLES_H_ */
@@ -4,4 +4,4 @@
 
 USER_OBJS :=
 
-LIBS := -lgstreamer-0.10
+LIBS := -lgstreamer-0.10 -lgstbase-0.10 -lgstaudio-0.10 -lgstapp-0.10
@@ -5,18 +5,72 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
 ../autoplugger.c \
+../autotune.c \
+../bench.c \
 ../gst-main.c \
-../typedetect.c 
+../gstxavidemux.c \
+../gstxoverlay.c \
+../gstxscale.c \
+../membudget.c \
+../plugin.c \
+../tunables.c \
+../typedetect.c \
+../xaudio.c \
+../xblend.c \
+../xconvert.c \
+../xloop.c \
+../xoverlay.c \
+../xplayer.c \
+../xposition.c \
+../xqos.c \
+../xrecovery.c \
+../xtrack.c 
 
 OBJS += \
 ./autoplugger.o \
+./autotune.o \
+./bench.o \
 ./gst-main.o \
-./typedetect.o 
+./gstxavidemux.o \
+./gstxoverlay.o \
+./gstxscale.o \
+./membudget.o \
+./plugin.o \
+./tunables.o \
+./typedetect.o \
+./xaudio.o \
+./xblend.o \
+./xconvert.o \
+./xloop.o \
+./xoverlay.o \
+./xplayer.o \
+./xposition.o \
+./xqos.o \
+./xrecovery.o \
+./xtrack.o 
 
 C_DEPS += \
 ./autoplugger.d \
+./autotune.d \
+./bench.d \
 ./gst-main.d \
-./typedetect.d 
+./gstxavidemux.d \
+./gstxoverlay.d \
+./gstxscale.d \
+./membudget.d \
+./plugin.d \
+./tunables.d \
+./typedetect.d \
+./xaudio.d \
+./xblend.d \
+./xconvert.d \
+./xloop.d \
+./xoverlay.d \
+./xplayer.d \
+./xposition.d \
+./xqos.d \
+./xrecovery.d \
+./xtrack.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -0,0 +1,180 @@
+/*
+ * xaudio.c - audio branch built from the demuxer pad caps
+ *
+ * Raw PCM goes straight from the queue to alsasink when the device takes
+ * the stream format as is, so no converter touches the samples. Anything
+ * else gets the best ranked audio decoder from the registry, followed by
+ * the converters, since the decoder output format is only known later.
+ * alsasink is asked for a small ring buffer; what the driver actually
+ * granted is reported once the pipeline has prerolled.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#include <stdio.h>
+#include <gst/gst.h>
+#include <gst/audio/gstbaseaudiosink.h>
+#include <glib.h>
+
+#include "xaudio.h"
+#include "autoplugger.h"
+
+static gboolean is_raw(const GstCaps * caps)
+{
+	const gchar * media = gst_structure_get_name(gst_caps_get_structure(caps, 0));
+
+	return !g_strcmp0(media, "audio/x-raw-int") || !g_strcmp0(media, "audio/x-raw-float");
+}
+
+/* whether the opened device takes caps without conversion */
+static gboolean sink_accepts(GstElement * AudioSink, const GstCaps * caps)
+{
+	GstPad * pad;
+	GstCaps * sinkcaps;
+	gboolean ret;
+
+	/* the pad only reports the device formats once it is open */
+	if(gst_element_set_state(AudioSink, GST_STATE_READY) == GST_STATE_CHANGE_FAILURE)
+		return FALSE;
+
+	pad = gst_element_get_static_pad(AudioSink, "sink");
+	sinkcaps = gst_pad_get_caps(pad);
+	ret = gst_caps_can_intersect(caps, sinkcaps);
+	gst_caps_unref(sinkcaps);
+	gst_object_unref(GST_OBJECT(pad));
+
+	return ret;
+}
+
+static inline void add_static_ghost_pad(GstElement * bin, GstElement * el, char * name)
+{
+	GstPad * pad;
+
+	pad = gst_element_get_static_pad(el, name);
+	gst_element_add_pad(bin, gst_ghost_pad_new(name, pad));
+	gst_object_unref(GST_OBJECT(pad));
+}
+
+GstElement * xaudio_bin_new(const GstCaps * caps, guint buffer_time, guint latency_time)
+{
+	GstElement * AudioBin;
+	GstElement * AudioQueue0;
+	GstElement * AudioDec = NULL;
+	GstElement * AudioConv = NULL;
+	GstElement * AudioResample = NULL;
+	GstElement * AudioSink;
+	GstElement * last;
+	gchar * str;
+
+	if(!caps || gst_caps_is_empty(caps) || gst_caps_is_any(caps))
+		return NULL;
+
+	str = gst_caps_to_string(caps);
+
+	AudioQueue0 = autoplug_factory_make("queue", "audio_queue0");
+	AudioSink = autoplug_factory_make("alsasink", "audio_sink");
+	if(!(AudioQueue0 && AudioSink))
+		goto fail;
+
+	g_object_set(G_OBJECT(AudioSink), "sync", FALSE, NULL);
+	g_object_set(G_OBJECT(AudioSink), "buffer-time", (gint64) buffer_time, NULL);
+	g_object_set(G_OBJECT(AudioSink), "latency-time", (gint64) latency_time, NULL);
+
+	if(is_raw(caps)) {
+		if(sink_accepts(AudioSink, caps)) {
+			g_print("Audio: PCM passthrough for %s\n", str);
+		}
+		else {
+			g_print("Audio: device does not take %s, converting\n", str);
+			AudioConv = autoplug_factory_make("audioconvert", "audio_convertor");
+			AudioResample = autoplug_factory_make("audioresample", "audio_resampler");
+			if(!(AudioConv && AudioResample))
+				goto fail;
+		}
+	}
+	else {
+		GstElementFactory * factory = autoplug_find_decoder(caps, "Audio");
+
+		if(!factory) {
+			g_print("Audio: no decoder for %s\n", str);
+			goto fail;
+		}
+		g_print("Audio: decoding %s with %s\n", str, gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory)));
+
+		AudioDec = gst_element_factory_create(factory, "audio_decoder");
+		AudioConv = autoplug_factory_make("audioconvert", "audio_convertor");
+		AudioResample = autoplug_factory_make("audioresample", "audio_resampler");
+		if(!(AudioDec && AudioConv && AudioResample))
+			goto fail;
+	}
+
+	AudioBin = gst_bin_new("audio_bin");
+	gst_bin_add_many(GST_BIN(AudioBin), AudioQueue0, AudioSink, NULL);
+	last = AudioQueue0;
+
+	if(AudioDec) {
+		gst_bin_add(GST_BIN(AudioBin), AudioDec);
+		gst_element_link(last, AudioDec);
+		last = AudioDec;
+	}
+	if(AudioConv) {
+		gst_bin_add_many(GST_BIN(AudioBin), AudioConv, AudioResample, NULL);
+		gst_element_link_many(last, AudioConv, AudioResample, NULL);
+		last = AudioResample;
+	}
+	gst_element_link(last, AudioSink);
+	add_static_ghost_pad(AudioBin, AudioQueue0, "sink");
+
+	g_free(str);
+
+	return AudioBin;
+
+fail:
+	if(AudioSink)
+		gst_element_set_state(AudioSink, GST_STATE_NULL);
+	if(AudioQueue0)
+		gst_object_unref(GST_OBJECT(AudioQueue0));
+	if(AudioDec)
+		gst_object_unref(GST_OBJECT(AudioDec));
+	if(AudioConv)
+		gst_object_unref(GST_OBJECT(AudioConv));
+	if(AudioResample)
+		gst_object_unref(GST_OBJECT(AudioResample));
+	if(AudioSink)
+		gst_object_unref(GST_OBJECT(AudioSink));
+	g_free(str);
+
+	return NULL;
+}
+
+/* what ALSA granted, the requested times are only a hint to the driver */
+void xaudio_report(GstElement * PipeLine)
+{
+	GstElement * AudioSink = gst_bin_get_by_name(GST_BIN(PipeLine), "audio_sink");
+	GstRingBuffer * ringbuffer;
+
+	if(!AudioSink)
+		return;
+
+	if(!GST_IS_BASE_AUDIO_SINK(AudioSink)) {
+		gst_object_unref(GST_OBJECT(AudioSink));
+		return;
+	}
+
+	GST_OBJECT_LOCK(AudioSink);
+	ringbuffer = GST_BASE_AUDIO_SINK(AudioSink)->ringbuffer;
+	if(ringbuffer && ringbuffer->spec.rate && ringbuffer->spec.bytes_per_sample) {
+		GstRingBufferSpec * spec = &ringbuffer->spec;
+		guint period = spec->segsize / spec->bytes_per_sample;
+		guint buffer = period * spec->segtotal;
+
+		g_print("Audio: %d Hz %d ch %d bit, period %u frames (%.1f ms), buffer %u frames (%.1f ms)\n",
+				spec->rate, spec->channels, spec->width,
+				period, period * 1000.0 / spec->rate,
+				buffer, buffer * 1000.0 / spec->rate);
+	}
+	GST_OBJECT_UNLOCK(AudioSink);
+
+	gst_object_unref(GST_OBJECT(AudioSink));
+}
@@ -0,0 +1,26 @@
+/*
+ * xaudio.h - audio branch built from the demuxer pad caps
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#ifndef XAUDIO_H_
+#define XAUDIO_H_
+
+#include <gst/gst.h>
+#include <glib.h>
+
+/* alsasink ring buffer, in microseconds */
+#ifdef MACH_IMX27
+#define XAUDIO_BUFFER_TIME	100000
+#define XAUDIO_LATENCY_TIME	20000
+#else
+#define XAUDIO_BUFFER_TIME	40000
+#define XAUDIO_LATENCY_TIME	10000
+#endif
+
+GstElement * xaudio_bin_new(const GstCaps * caps, guint buffer_time, guint latency_time);
+void xaudio_report(GstElement * PipeLine);
+
+#endif /* XAUDIO_H_ */
@@ -0,0 +1,153 @@
+/*
+ * xblend.c - alpha blend kernels for the overlay
+ *
+ * Overlay pixels are mostly fully transparent (around the glyphs) or fully
+ * opaque (inside them), so the fast kernels look at the alpha a block at a
+ * time and only do the arithmetic on the edges. The skip kernel tests a 32
+ * bit word of alpha at a time and skips or copies it, the edges are blended
+ * byte by byte as in the scalar one. It is the one for the ARM926, which has
+ * no SIMD. SSE2 tests and blends 16 bytes at a time. The division by 255 is
+ * done exactly, so alpha 0 leaves the frame untouched and alpha 255 copies
+ * the overlay.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#include <string.h>
+#include <glib.h>
+
+#include "xblend.h"
+
+#if defined(ARCH_X86) && (defined(__i386__) || defined(__x86_64__)) && \
+	(__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define XBLEND_HAVE_SSE2	1
+#include <emmintrin.h>
+#endif
+
+static inline guint8 blend_pixel(guint d, guint s, guint a)
+{
+	guint t = s * a + d * (255 - a) + 128;
+
+	return (guint8) ((t + (t >> 8)) >> 8);
+}
+
+static void blend_row_scalar(guint8 * dst, const guint8 * src, const guint8 * alpha, gint n)
+{
+	gint i;
+
+	for(i = 0; i < n; i++)
+		dst[i] = blend_pixel(dst[i], src[i], alpha[i]);
+}
+
+/*
+ * Four alpha bytes per load, alpha and src are aligned once alpha is (the
+ * overlay planes share the stride). dst is the frame at the overlay
+ * position and only gets word stores when that is aligned too.
+ */
+static void blend_row_skip(guint8 * dst, const guint8 * src, const guint8 * alpha, gint n)
+{
+	gboolean dst_aligned;
+	guint32 a, s;
+	gint i = 0;
+
+	for(; i < n && ((gsize) (alpha + i) & 3); i++)
+		dst[i] = blend_pixel(dst[i], src[i], alpha[i]);
+	dst_aligned = !((gsize) (dst + i) & 3);
+
+	for(; i + 4 <= n; i += 4) {
+		memcpy(&a, alpha + i, 4);
+
+		if(a == 0)
+			continue;
+		if(a == 0xffffffff) {
+			memcpy(&s, src + i, 4);
+			if(dst_aligned)
+				*(guint32 *) (dst + i) = s;
+			else
+				memcpy(dst + i, &s, 4);
+			continue;
+		}
+		dst[i] = blend_pixel(dst[i], src[i], alpha[i]);
+		dst[i + 1] = blend_pixel(dst[i + 1], src[i + 1], alpha[i + 1]);
+		dst[i + 2] = blend_pixel(dst[i + 2], src[i + 2], alpha[i + 2]);
+		dst[i + 3] = blend_pixel(dst[i + 3], src[i + 3], alpha[i + 3]);
+	}
+
+	blend_row_scalar(dst + i, src + i, alpha + i, n - i);
+}
+
+#ifdef XBLEND_HAVE_SSE2
+
+/* s * a + d * (255 - a) stays below 65536, so unsigned 16 bit lanes hold it */
+__attribute__((target("sse2")))
+static inline __m128i blend8_sse2(__m128i d, __m128i s, __m128i a)
+{
+	__m128i t = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(s, a),
+			_mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(255), a))), _mm_set1_epi16(128));
+
+	return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+__attribute__((target("sse2")))
+static void blend_row_sse2(guint8 * dst, const guint8 * src, const guint8 * alpha, gint n)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i ones = _mm_set1_epi8((char) 0xff);
+	gint i;
+
+	for(i = 0; i + 16 <= n; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i *) (alpha + i));
+		__m128i s, d;
+
+		if(_mm_movemask_epi8(_mm_cmpeq_epi8(a, zero)) == 0xffff)
+			continue;
+		s = _mm_loadu_si128((const __m128i *) (src + i));
+		if(_mm_movemask_epi8(_mm_cmpeq_epi8(a, ones)) == 0xffff) {
+			_mm_storeu_si128((__m128i *) (dst + i), s);
+			continue;
+		}
+		d = _mm_loadu_si128((const __m128i *) (dst + i));
+		_mm_storeu_si128((__m128i *) (dst + i), _mm_packus_epi16(
+				blend8_sse2(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(a, zero)),
+				blend8_sse2(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(a, zero))));
+	}
+
+	blend_row_scalar(dst + i, src + i, alpha + i, n - i);
+}
+
+#endif /* XBLEND_HAVE_SSE2 */
+
+static const xBlendKernels kernels[XBLEND_IMPL_COUNT] = {
+	[XBLEND_SCALAR] = { "scalar", blend_row_scalar },
+	[XBLEND_SKIP] = { "skip", blend_row_skip },
+#ifdef XBLEND_HAVE_SSE2
+	[XBLEND_SSE2] = { "sse2", blend_row_sse2 },
+#endif
+};
+
+const xBlendKernels * xblend_kernels_get(xBlendImpl impl)
+{
+	if(impl >= XBLEND_IMPL_COUNT || !kernels[impl].name)
+		return NULL;
+
+#ifdef XBLEND_HAVE_SSE2
+	__builtin_cpu_init();
+	if(impl == XBLEND_SSE2 && !__builtin_cpu_supports("sse2"))
+		return NULL;
+#endif
+
+	return &kernels[impl];
+}
+
+const xBlendKernels * xblend_kernels_best(void)
+{
+	gint impl;
+
+	for(impl = XBLEND_IMPL_COUNT - 1; impl > XBLEND_SCALAR; impl--) {
+		if(xblend_kernels_get((xBlendImpl) impl))
+			return &kernels[impl];
+	}
+
+	return &kernels[XBLEND_SCALAR];
+}
@@ -0,0 +1,30 @@
+/*
+ * xblend.h - alpha blend kernels for the overlay
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#ifndef XBLEND_H_
+#define XBLEND_H_
+
+#include <glib.h>
+
+typedef enum {
+	XBLEND_SCALAR,
+	XBLEND_SKIP,			/* skips and copies by the word, blends bytewise */
+	XBLEND_SSE2,
+	XBLEND_IMPL_COUNT
+} xBlendImpl;
+
+/* dst = (src * a + dst * (255 - a)) / 255 per byte, rounded. All
+ * implementations produce bit-exact results. */
+typedef struct {
+	const gchar * name;
+	void (*blend_row)(guint8 * dst, const guint8 * src, const guint8 * alpha, gint n);
+} xBlendKernels;
+
+const xBlendKernels * xblend_kernels_get(xBlendImpl impl);
+const xBlendKernels * xblend_kernels_best(void);
+
+#endif /* XBLEND_H_ */
@@ -0,0 +1,495 @@
+/*
+ * xconvert.c - YUV to RGB32 conversion and bilinear scaling kernels
+ *
+ * The arithmetic is 16 bit fixed point with 6 fractional bits and saturating
+ * adds, which is what SSE2 does natively; the scalar path emulates the same
+ * saturation so every implementation gives the same pixels.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#include <string.h>
+#include <glib.h>
+
+#include "xconvert.h"
+
+#if defined(ARCH_X86) && (defined(__i386__) || defined(__x86_64__)) && \
+	(__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define XCONV_HAVE_SIMD	1
+#include <immintrin.h>
+#endif
+
+#define FOURCC(a, b, c, d)	((guint32) (a) | ((guint32) (b) << 8) | ((guint32) (c) << 16) | ((guint32) (d) << 24))
+#define FOURCC_I420	FOURCC('I', '4', '2', '0')
+#define FOURCC_YV12	FOURCC('Y', 'V', '1', '2')
+#define FOURCC_YUY2	FOURCC('Y', 'U', 'Y', '2')
+
+#define ROUND_UP_2(n)	(((n) + 1) & ~1)
+#define ROUND_UP_4(n)	(((n) + 3) & ~3)
+
+/* BT.601 coefficients scaled by 64 */
+#define CY	74
+#define CRV	102
+#define CGV	52
+#define CGU	25
+#define CBU	129
+
+static inline gint sat16(gint v)
+{
+	return v > 32767 ? 32767 : (v < -32768 ? -32768 : v);
+}
+
+static inline guint8 clamp8(gint v)
+{
+	return v > 255 ? 255 : (v < 0 ? 0 : v);
+}
+
+static inline void yuv_pixel(gint y, gint u, gint v, guint8 * dst)
+{
+	gint yy = (y - 16) * CY;
+
+	u -= 128;
+	v -= 128;
+	dst[0] = clamp8(sat16(yy + CBU * u) >> 6);
+	dst[1] = clamp8(sat16(sat16(yy - CGV * v) - CGU * u) >> 6);
+	dst[2] = clamp8(sat16(yy + CRV * v) >> 6);
+	dst[3] = 0xff;
+}
+
+static void i420_row_scalar(const guint8 * y, const guint8 * u, const guint8 * v, guint8 * dst, gint width)
+{
+	gint x;
+
+	for(x = 0; x < width; x++)
+		yuv_pixel(y[x], u[x >> 1], v[x >> 1], dst + x * 4);
+}
+
+static void yuy2_row_scalar(const guint8 * src, guint8 * dst, gint width)
+{
+	gint x;
+
+	for(x = 0; x < width; x++)
+		yuv_pixel(src[x * 2], src[(x & ~1) * 2 + 1], src[(x & ~1) * 2 + 3], dst + x * 4);
+}
+
+static void vblend_row_scalar(const guint8 * r0, const guint8 * r1, guint8 * dst, gint bytes, gint frac)
+{
+	gint i;
+
+	for(i = 0; i < bytes; i++)
+		dst[i] = (guint8) (((guint) r0[i] * (256 - frac) + (guint) r1[i] * frac) >> 8);
+}
+
+/* two pixels per step: red/blue and alpha/green lanes of a 32 bit word */
+static void hscale_row_scalar(const guint32 * src, guint32 * dst, const gint * xofs, const guint8 * xfrac, gint in_w, gint out_w)
+{
+	gint x;
+
+	for(x = 0; x < out_w; x++) {
+		guint f = xfrac[x];
+		guint32 p0 = src[xofs[x]];
+		guint32 p1 = src[MIN(xofs[x] + 1, in_w - 1)];
+		guint32 rb = (((p0 & 0xff00ff) * (256 - f) + (p1 & 0xff00ff) * f) >> 8) & 0xff00ff;
+		guint32 ag = (((p0 >> 8) & 0xff00ff) * (256 - f) + ((p1 >> 8) & 0xff00ff) * f) & 0xff00ff00;
+
+		dst[x] = rb | ag;
+	}
+}
+
+#ifdef XCONV_HAVE_SIMD
+
+/* r, g, b as 8 x int16 each, results written as 8 BGRx pixels */
+__attribute__((target("sse2")))
+static inline void store_bgrx_sse2(__m128i r, __m128i g, __m128i b, guint8 * dst)
+{
+	__m128i alpha = _mm_set1_epi8((char) 0xff);
+	__m128i r8 = _mm_packus_epi16(_mm_srai_epi16(r, 6), _mm_setzero_si128());
+	__m128i g8 = _mm_packus_epi16(_mm_srai_epi16(g, 6), _mm_setzero_si128());
+	__m128i b8 = _mm_packus_epi16(_mm_srai_epi16(b, 6), _mm_setzero_si128());
+	__m128i bg = _mm_unpacklo_epi8(b8, g8);
+	__m128i ra = _mm_unpacklo_epi8(r8, alpha);
+
+	_mm_storeu_si128((__m128i *) dst, _mm_unpacklo_epi16(bg, ra));
+	_mm_storeu_si128((__m128i *) (dst + 16), _mm_unpackhi_epi16(bg, ra));
+}
+
+/* y, u, v as 8 x int16 each, chroma already duplicated per pixel */
+__attribute__((target("sse2")))
+static inline void yuv8_sse2(__m128i y, __m128i u, __m128i v, guint8 * dst)
+{
+	__m128i yy = _mm_mullo_epi16(_mm_sub_epi16(y, _mm_set1_epi16(16)), _mm_set1_epi16(CY));
+	__m128i r, g, b;
+
+	u = _mm_sub_epi16(u, _mm_set1_epi16(128));
+	v = _mm_sub_epi16(v, _mm_set1_epi16(128));
+
+	r = _mm_adds_epi16(yy, _mm_mullo_epi16(v, _mm_set1_epi16(CRV)));
+	g = _mm_subs_epi16(_mm_subs_epi16(yy, _mm_mullo_epi16(v, _mm_set1_epi16(CGV))), _mm_mullo_epi16(u, _mm_set1_epi16(CGU)));
+	b = _mm_adds_epi16(yy, _mm_mullo_epi16(u, _mm_set1_epi16(CBU)));
+
+	store_bgrx_sse2(r, g, b, dst);
+}
+
+__attribute__((target("sse2")))
+static void i420_row_sse2(const guint8 * y, const guint8 * u, const guint8 * v, guint8 * dst, gint width)
+{
+	__m128i zero = _mm_setzero_si128();
+	gint x;
+
+	for(x = 0; x + 16 <= width; x += 16) {
+		__m128i y8 = _mm_loadu_si128((const __m128i *) (y + x));
+		__m128i u8 = _mm_loadl_epi64((const __m128i *) (u + x / 2));
+		__m128i v8 = _mm_loadl_epi64((const __m128i *) (v + x / 2));
+
+		u8 = _mm_unpacklo_epi8(u8, u8);
+		v8 = _mm_unpacklo_epi8(v8, v8);
+
+		yuv8_sse2(_mm_unpacklo_epi8(y8, zero), _mm_unpacklo_epi8(u8, zero), _mm_unpacklo_epi8(v8, zero), dst + x * 4);
+		yuv8_sse2(_mm_unpackhi_epi8(y8, zero), _mm_unpackhi_epi8(u8, zero), _mm_unpackhi_epi8(v8, zero), dst + x * 4 + 32);
+	}
+
+	i420_row_scalar(y + x, u + x / 2, v + x / 2, dst + x * 4, width - x);
+}
+
+__attribute__((target("sse2")))
+static void yuy2_row_sse2(const guint8 * src, guint8 * dst, gint width)
+{
+	__m128i lo8 = _mm_set1_epi16(0x00ff);
+	__m128i lo16 = _mm_set1_epi32(0x0000ffff);
+	gint x;
+
+	for(x = 0; x + 8 <= width; x += 8) {
+		__m128i p = _mm_loadu_si128((const __m128i *) (src + x * 2));
+		__m128i y = _mm_and_si128(p, lo8);
+		__m128i uv = _mm_srli_epi16(p, 8);
+		__m128i u = _mm_and_si128(uv, lo16);
+		__m128i v = _mm_srli_epi32(uv, 16);
+
+		u = _mm_or_si128(u, _mm_slli_epi32(u, 16));
+		v = _mm_or_si128(v, _mm_slli_epi32(v, 16));
+
+		yuv8_sse2(y, u, v, dst + x * 4);
+	}
+
+	yuy2_row_scalar(src + x * 2, dst + x * 4, width - x);
+}
+
+__attribute__((target("sse2")))
+static void vblend_row_sse2(const guint8 * r0, const guint8 * r1, guint8 * dst, gint bytes, gint frac)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i f0 = _mm_set1_epi16(256 - frac);
+	__m128i f1 = _mm_set1_epi16(frac);
+	gint i;
+
+	for(i = 0; i + 16 <= bytes; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i *) (r0 + i));
+		__m128i b = _mm_loadu_si128((const __m128i *) (r1 + i));
+		__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), f0), _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), f1));
+		__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), f0), _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), f1));
+
+		_mm_storeu_si128((__m128i *) (dst + i), _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+	}
+
+	vblend_row_scalar(r0 + i, r1 + i, dst + i, bytes - i, frac);
+}
+
+/* the source pixels are picked one by one, the blend runs 4 pixels wide */
+__attribute__((target("sse2")))
+static void hscale_row_sse2(const guint32 * src, guint32 * dst, const gint * xofs, const guint8 * xfrac, gint in_w, gint out_w)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i full = _mm_set1_epi16(256);
+	gint x;
+
+	for(x = 0; x + 4 <= out_w; x += 4) {
+		const gint * o = xofs + x;
+		__m128i p0 = _mm_set_epi32((gint) src[o[3]], (gint) src[o[2]], (gint) src[o[1]], (gint) src[o[0]]);
+		__m128i p1 = _mm_set_epi32((gint) src[MIN(o[3] + 1, in_w - 1)], (gint) src[MIN(o[2] + 1, in_w - 1)],
+				(gint) src[MIN(o[1] + 1, in_w - 1)], (gint) src[MIN(o[0] + 1, in_w - 1)]);
+		__m128i f = _mm_cvtsi32_si128((gint) (xfrac[x] | (xfrac[x + 1] << 8) | (xfrac[x + 2] << 16) | ((guint32) xfrac[x + 3] << 24)));
+		__m128i f1lo, f1hi, lo, hi;
+
+		/* every fraction over the 4 bytes of its pixel */
+		f = _mm_unpacklo_epi8(f, f);
+		f = _mm_unpacklo_epi16(f, f);
+		f1lo = _mm_unpacklo_epi8(f, zero);
+		f1hi = _mm_unpackhi_epi8(f, zero);
+
+		lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(p0, zero), _mm_sub_epi16(full, f1lo)), _mm_mullo_epi16(_mm_unpacklo_epi8(p1, zero), f1lo));
+		hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(p0, zero), _mm_sub_epi16(full, f1hi)), _mm_mullo_epi16(_mm_unpackhi_epi8(p1, zero), f1hi));
+
+		_mm_storeu_si128((__m128i *) (dst + x), _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+	}
+
+	hscale_row_scalar(src, dst + x, xofs + x, xfrac + x, in_w, out_w - x);
+}
+
+/* the arithmetic runs 16 pixels wide, packing goes through the SSE2 store */
+__attribute__((target("avx2")))
+static void i420_row_avx2(const guint8 * y, const guint8 * u, const guint8 * v, guint8 * dst, gint width)
+{
+	gint x;
+
+	for(x = 0; x + 16 <= width; x += 16) {
+		__m128i u8 = _mm_loadl_epi64((const __m128i *) (u + x / 2));
+		__m128i v8 = _mm_loadl_epi64((const __m128i *) (v + x / 2));
+		__m256i yw = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (y + x)));
+		__m256i uw = _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(u8, u8));
+		__m256i vw = _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(v8, v8));
+		__m256i yy, r, g, b;
+
+		yy = _mm256_mullo_epi16(_mm256_sub_epi16(yw, _mm256_set1_epi16(16)), _mm256_set1_epi16(CY));
+		uw = _mm256_sub_epi16(uw, _mm256_set1_epi16(128));
+		vw = _mm256_sub_epi16(vw, _mm256_set1_epi16(128));
+
+		r = _mm256_adds_epi16(yy, _mm256_mullo_epi16(vw, _mm256_set1_epi16(CRV)));
+		g = _mm256_subs_epi16(_mm256_subs_epi16(yy, _mm256_mullo_epi16(vw, _mm256_set1_epi16(CGV))), _mm256_mullo_epi16(uw, _mm256_set1_epi16(CGU)));
+		b = _mm256_adds_epi16(yy, _mm256_mullo_epi16(uw, _mm256_set1_epi16(CBU)));
+
+		store_bgrx_sse2(_mm256_castsi256_si128(r), _mm256_castsi256_si128(g), _mm256_castsi256_si128(b), dst + x * 4);
+		store_bgrx_sse2(_mm256_extracti128_si256(r, 1), _mm256_extracti128_si256(g, 1), _mm256_extracti128_si256(b, 1), dst + x * 4 + 32);
+	}
+
+	i420_row_scalar(y + x, u + x / 2, v + x / 2, dst + x * 4, width - x);
+}
+
+__attribute__((target("avx2")))
+static void vblend_row_avx2(const guint8 * r0, const guint8 * r1, guint8 * dst, gint bytes, gint frac)
+{
+	__m256i f0 = _mm256_set1_epi16(256 - frac);
+	__m256i f1 = _mm256_set1_epi16(frac);
+	gint i;
+
+	for(i = 0; i + 16 <= bytes; i += 16) {
+		__m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (r0 + i)));
+		__m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (r1 + i)));
+		__m256i s = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(a, f0), _mm256_mullo_epi16(b, f1)), 8);
+
+		_mm_storeu_si128((__m128i *) (dst + i), _mm_packus_epi16(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1)));
+	}
+
+	vblend_row_scalar(r0 + i, r1 + i, dst + i, bytes - i, frac);
+}
+
+/* 8 pixels a step, the source pixels are fetched with gathers */
+__attribute__((target("avx2")))
+static void hscale_row_avx2(const guint32 * src, guint32 * dst, const gint * xofs, const guint8 * xfrac, gint in_w, gint out_w)
+{
+	__m256i one = _mm256_set1_epi32(1);
+	__m256i last = _mm256_set1_epi32(in_w - 1);
+	__m256i full = _mm256_set1_epi16(256);
+	gint x;
+
+	for(x = 0; x + 8 <= out_w; x += 8) {
+		__m256i i0 = _mm256_loadu_si256((const __m256i *) (xofs + x));
+		__m256i i1 = _mm256_min_epi32(_mm256_add_epi32(i0, one), last);
+		__m256i p0 = _mm256_i32gather_epi32((const int *) src, i0, 4);
+		__m256i p1 = _mm256_i32gather_epi32((const int *) src, i1, 4);
+		__m128i f = _mm_loadl_epi64((const __m128i *) (xfrac + x));
+		__m256i f1lo, f1hi, lo, hi;
+
+		/* every fraction over the 4 bytes of its pixel */
+		f = _mm_unpacklo_epi8(f, f);
+		f1lo = _mm256_cvtepu8_epi16(_mm_unpacklo_epi16(f, f));
+		f1hi = _mm256_cvtepu8_epi16(_mm_unpackhi_epi16(f, f));
+
+		lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(p0)), _mm256_sub_epi16(full, f1lo)),
+				_mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(p1)), f1lo));
+		hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(p0, 1)), _mm256_sub_epi16(full, f1hi)),
+				_mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(p1, 1)), f1hi));
+		lo = _mm256_srli_epi16(lo, 8);
+		hi = _mm256_srli_epi16(hi, 8);
+
+		_mm_storeu_si128((__m128i *) (dst + x), _mm_packus_epi16(_mm256_castsi256_si128(lo), _mm256_extracti128_si256(lo, 1)));
+		_mm_storeu_si128((__m128i *) (dst + x + 4), _mm_packus_epi16(_mm256_castsi256_si128(hi), _mm256_extracti128_si256(hi, 1)));
+	}
+
+	hscale_row_scalar(src, dst + x, xofs + x, xfrac + x, in_w, out_w - x);
+}
+
+#endif /* XCONV_HAVE_SIMD */
+
+static const xConvKernels kernels[XCONV_IMPL_COUNT] = {
+	[XCONV_SCALAR] = { "scalar", i420_row_scalar, yuy2_row_scalar, vblend_row_scalar, hscale_row_scalar },
+#ifdef XCONV_HAVE_SIMD
+	[XCONV_SSE2] = { "sse2", i420_row_sse2, yuy2_row_sse2, vblend_row_sse2, hscale_row_sse2 },
+	/* YUY2 deinterleaving gains nothing from the wider registers */
+	[XCONV_AVX2] = { "avx2", i420_row_avx2, yuy2_row_sse2, vblend_row_avx2, hscale_row_avx2 },
+#endif
+};
+
+const xConvKernels * xconv_kernels_get(xConvImpl impl)
+{
+	if(impl >= XCONV_IMPL_COUNT || !kernels[impl].name)
+		return NULL;
+
+#ifdef XCONV_HAVE_SIMD
+	__builtin_cpu_init();
+	if(impl == XCONV_SSE2 && !__builtin_cpu_supports("sse2"))
+		return NULL;
+	if(impl == XCONV_AVX2 && !__builtin_cpu_supports("avx2"))
+		return NULL;
+#endif
+
+	return &kernels[impl];
+}
+
+const xConvKernels * xconv_kernels_best(void)
+{
+	gint impl;
+
+	for(impl = XCONV_IMPL_COUNT - 1; impl > XCONV_SCALAR; impl--) {
+		if(xconv_kernels_get((xConvImpl) impl))
+			return &kernels[impl];
+	}
+
+	return &kernels[XCONV_SCALAR];
+}
+
+/* plane layout as used by the GStreamer 0.10 raw video caps */
+guint xconv_input_size(guint32 fourcc, gint width, gint height)
+{
+	switch(fourcc) {
+	case FOURCC_I420:
+	case FOURCC_YV12:
+		return ROUND_UP_4(width) * ROUND_UP_2(height) + ROUND_UP_4(ROUND_UP_2(width) / 2) * ROUND_UP_2(height);
+	case FOURCC_YUY2:
+		return ROUND_UP_4(width * 2) * height;
+	default:
+		return 0;
+	}
+}
+
+gboolean xconv_setup(xConvContext * c, const xConvKernels * k, guint32 fourcc, gint in_w, gint in_h, gint out_w, gint out_h)
+{
+	gint x;
+
+	xconv_free(c);
+
+	if(!xconv_input_size(fourcc, in_w, in_h) || in_w <= 0 || in_h <= 0 || out_w <= 0 || out_h <= 0)
+		return FALSE;
+
+	c->k = k;
+	c->fourcc = fourcc;
+	c->in_w = in_w;
+	c->in_h = in_h;
+	c->out_w = out_w;
+	c->out_h = out_h;
+
+	c->xofs = g_new(gint, out_w);
+	c->xfrac = g_new(guint8, out_w);
+	for(x = 0; x < out_w; x++) {
+		/* pixel centres, 8 bit fraction */
+		gint sx = (gint) (((gint64) (2 * x + 1) * in_w * 256) / (2 * out_w)) - 128;
+
+		if(sx < 0)
+			sx = 0;
+		c->xofs[x] = sx >> 8;
+		c->xfrac[x] = sx & 0xff;
+		if(c->xofs[x] >= in_w - 1) {
+			c->xofs[x] = in_w - 1;
+			c->xfrac[x] = 0;
+		}
+	}
+
+	c->rowbuf = g_malloc(in_w * 4);
+	c->hrow[0] = g_malloc(out_w * 4);
+	c->hrow[1] = g_malloc(out_w * 4);
+
+	return TRUE;
+}
+
+void xconv_free(xConvContext * c)
+{
+	g_free(c->xofs);
+	g_free(c->xfrac);
+	g_free(c->rowbuf);
+	g_free(c->hrow[0]);
+	g_free(c->hrow[1]);
+	memset(c, 0, sizeof(xConvContext));
+}
+
+static void convert_row(xConvContext * c, const guint8 * src, gint row, guint8 * dst)
+{
+	if(c->fourcc == FOURCC_YUY2) {
+		c->k->yuy2_row(src + row * ROUND_UP_4(c->in_w * 2), dst, c->in_w);
+	}
+	else {
+		gint ystride = ROUND_UP_4(c->in_w);
+		gint cstride = ROUND_UP_4(ROUND_UP_2(c->in_w) / 2);
+		const guint8 * u = src + ystride * ROUND_UP_2(c->in_h);
+		const guint8 * v = u + cstride * (ROUND_UP_2(c->in_h) / 2);
+
+		if(c->fourcc == FOURCC_YV12) {
+			const guint8 * t = u;
+			u = v;
+			v = t;
+		}
+		c->k->i420_row(src + row * ystride, u + (row / 2) * cstride, v + (row / 2) * cstride, dst, c->in_w);
+	}
+}
+
+static const guint8 * get_hrow(xConvContext * c, const guint8 * src, gint row)
+{
+	gint slot;
+
+	if(c->hidx[0] == row)
+		return c->hrow[0];
+	if(c->hidx[1] == row)
+		return c->hrow[1];
+
+	/* rows only move down through the frame, drop the older one */
+	slot = c->hidx[0] < c->hidx[1] ? 0 : 1;
+
+	if(c->in_w == c->out_w) {
+		convert_row(c, src, row, c->hrow[slot]);
+	}
+	else {
+		convert_row(c, src, row, c->rowbuf);
+		c->k->hscale_row((const guint32 *) c->rowbuf, (guint32 *) c->hrow[slot], c->xofs, c->xfrac, c->in_w, c->out_w);
+	}
+	c->hidx[slot] = row;
+
+	return c->hrow[slot];
+}
+
+void xconv_frame(xConvContext * c, const guint8 * src, guint8 * dst)
+{
+	gint stride = c->out_w * 4;
+	gint y;
+
+	if(c->in_w == c->out_w && c->in_h == c->out_h) {
+		for(y = 0; y < c->out_h; y++)
+			convert_row(c, src, y, dst + y * stride);
+		return;
+	}
+
+	c->hidx[0] = c->hidx[1] = -1;
+
+	for(y = 0; y < c->out_h; y++) {
+		gint sy = (gint) (((gint64) (2 * y + 1) * c->in_h * 256) / (2 * c->out_h)) - 128;
+		gint row, frac;
+		const guint8 * r0;
+		const guint8 * r1;
+
+		if(sy < 0)
+			sy = 0;
+		row = sy >> 8;
+		frac = sy & 0xff;
+		if(row >= c->in_h - 1) {
+			row = c->in_h - 1;
+			frac = 0;
+		}
+
+		r0 = get_hrow(c, src, row);
+		if(frac) {
+			r1 = get_hrow(c, src, row + 1);
+			c->k->vblend_row(r0, r1, dst + y * stride, stride, frac);
+		}
+		else {
+			memcpy(dst + y * stride, r0, stride);
+		}
+	}
+}
@@ -0,0 +1,52 @@
+/*
+ * xconvert.h - YUV to RGB32 conversion and bilinear scaling kernels
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#ifndef XCONVERT_H_
+#define XCONVERT_H_
+
+#include <glib.h>
+
+typedef enum {
+	XCONV_SCALAR,
+	XCONV_SSE2,
+	XCONV_AVX2,
+	XCONV_IMPL_COUNT
+} xConvImpl;
+
+/* Output is 32 bit BGRx in memory order, 8 bit fixed point BT.601. All
+ * implementations produce bit-exact results. */
+typedef struct {
+	const gchar * name;
+	void (*i420_row)(const guint8 * y, const guint8 * u, const guint8 * v, guint8 * dst, gint width);
+	void (*yuy2_row)(const guint8 * src, guint8 * dst, gint width);
+	/* dst = (r0 * (256 - frac) + r1 * frac) >> 8, per byte */
+	void (*vblend_row)(const guint8 * r0, const guint8 * r1, guint8 * dst, gint bytes, gint frac);
+	/* dst[x] = src[xofs[x]] and the next pixel blended by xfrac[x], per byte like vblend_row */
+	void (*hscale_row)(const guint32 * src, guint32 * dst, const gint * xofs, const guint8 * xfrac, gint in_w, gint out_w);
+} xConvKernels;
+
+typedef struct {
+	const xConvKernels * k;
+	guint32 fourcc;
+	gint in_w, in_h;
+	gint out_w, out_h;
+	gint * xofs;
+	guint8 * xfrac;
+	guint8 * rowbuf;
+	guint8 * hrow[2];
+	gint hidx[2];
+} xConvContext;
+
+const xConvKernels * xconv_kernels_get(xConvImpl impl);
+const xConvKernels * xconv_kernels_best(void);
+
+gboolean xconv_setup(xConvContext * c, const xConvKernels * k, guint32 fourcc, gint in_w, gint in_h, gint out_w, gint out_h);
+guint xconv_input_size(guint32 fourcc, gint width, gint height);
+void xconv_frame(xConvContext * c, const guint8 * src, guint8 * dst);
+void xconv_free(xConvContext * c);
+
+#endif /* XCONVERT_H_ */
@@ -0,0 +1,433 @@
+/*
+ * xloop.c - seamless looping and decoded frame cache
+ *
+ * The clip is played as a segment. When the pipeline posts SEGMENT_DONE a
+ * non-flushing segment seek back to the start is sent, so the sinks only
+ * see a new segment and keep their running time, there is no EOS and no
+ * preroll in between. Demuxers without segment seeks end in EOS, that is
+ * turned into a flushing seek so the clip still loops, if not seamlessly.
+ *
+ * With a cache limit, the frames the video sink gets during one full pass
+ * are copied to system memory. QoS frame dropping is suspended for that
+ * pass, a frame dropped then would be missing from every replay. If the
+ * clip fits, the sink is moved over to a small appsrc pipeline replaying
+ * the cache, and the demuxer and the decoder (the VPU on the i.MX27) are
+ * shut down. The replay is paced by the sink clock, so the sink is made to
+ * sync even where it does not while decoding. Clips with sound are not
+ * cached, only the video would be replayed.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <glib.h>
+
+#include "xloop.h"
+#include "autoplugger.h"
+
+#define XLOOP_CACHE_READY	"xloop-cache-ready"
+
+static gboolean segment_seek(GstElement * PipeLine, gboolean flush)
+{
+	GstSeekFlags flags = GST_SEEK_FLAG_SEGMENT;
+
+	if(flush)
+		flags |= GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT;
+
+	if(!gst_element_seek(PipeLine, 1.0, GST_FORMAT_TIME, flags,
+			GST_SEEK_TYPE_SET, 0, GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE)) {
+		g_print("Loop: seek failed\n");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* lock held */
+static void set_capturing(xLoop * loop, gboolean capturing)
+{
+	loop->capturing = capturing;
+	if(loop->qos)
+		xqos_suspend(loop->qos, capturing);
+}
+
+/* lock held */
+static void cache_clear(xLoop * loop)
+{
+	guint i;
+
+	for(i = 0; i < loop->frames->len; i++)
+		gst_buffer_unref(GST_BUFFER(g_ptr_array_index(loop->frames, i)));
+	g_ptr_array_set_size(loop->frames, 0);
+	mem_budget_charge(loop->budget, MEM_COMP_FRAME_CACHE, -(gint) loop->cache_size);
+	loop->cache_size = 0;
+	gst_caps_replace(&loop->caps, NULL);
+}
+
+/* lock held, the pass is complete */
+static void cache_finish(xLoop * loop)
+{
+	GstBuffer * first = GST_BUFFER(g_ptr_array_index(loop->frames, 0));
+	GstBuffer * last = GST_BUFFER(g_ptr_array_index(loop->frames, loop->frames->len - 1));
+	GstClockTime frame;
+
+	if(GST_BUFFER_DURATION_IS_VALID(last))
+		frame = GST_BUFFER_DURATION(last);
+	else if(loop->frames->len > 1)
+		frame = (GST_BUFFER_TIMESTAMP(last) - GST_BUFFER_TIMESTAMP(first)) / (loop->frames->len - 1);
+	else
+		frame = 40 * GST_MSECOND;
+
+	loop->duration = GST_BUFFER_TIMESTAMP(last) + frame;
+	set_capturing(loop, FALSE);
+	loop->cache_ready = TRUE;
+
+	g_print("Loop: %u frames, %u bytes, %" GST_TIME_FORMAT " cached\n",
+			loop->frames->len, loop->cache_size, GST_TIME_ARGS(loop->duration));
+}
+
+static gboolean cache_buffer_probe(GstPad * pad, GstBuffer * buf, void * data)
+{
+	xLoop * loop = (xLoop *) data;
+
+	g_static_mutex_lock(&loop->lock);
+	loop->last_ts = GST_BUFFER_TIMESTAMP(buf);
+
+	if(loop->capturing) {
+		if(!GST_BUFFER_TIMESTAMP_IS_VALID(buf) || loop->cache_size + GST_BUFFER_SIZE(buf) > loop->cache_limit) {
+			g_print("Loop: clip does not fit the %u byte frame cache\n", loop->cache_limit);
+			cache_clear(loop);
+			set_capturing(loop, FALSE);
+			loop->cache_limit = 0;
+		}
+		else {
+			/* out of the decoder's buffer pool, into plain memory */
+			if(!loop->caps)
+				gst_caps_replace(&loop->caps, GST_BUFFER_CAPS(buf));
+			g_ptr_array_add(loop->frames, gst_buffer_copy(buf));
+			loop->cache_size += GST_BUFFER_SIZE(buf);
+			mem_budget_charge(loop->budget, MEM_COMP_FRAME_CACHE, GST_BUFFER_SIZE(buf));
+		}
+	}
+	g_static_mutex_unlock(&loop->lock);
+
+	return TRUE;
+}
+
+static gboolean cache_event_probe(GstPad * pad, GstEvent * event, void * data)
+{
+	xLoop * loop = (xLoop *) data;
+
+	switch(GST_EVENT_TYPE(event)) {
+	case GST_EVENT_NEWSEGMENT:
+	{
+		gboolean update;
+		gdouble rate;
+		GstFormat format;
+		gint64 start, stop, time;
+		GstElement * AudioBin;
+
+		gst_event_parse_new_segment(event, &update, &rate, &format, &start, &stop, &time);
+		if(update || format != GST_FORMAT_TIME)
+			break;
+
+		g_static_mutex_lock(&loop->lock);
+		if(loop->capturing && loop->frames->len) {
+			/* the loop seek came through, everything of the pass is in */
+			cache_finish(loop);
+			gst_element_post_message(GST_ELEMENT(GST_PAD_PARENT(pad)),
+					gst_message_new_application(GST_OBJECT(GST_PAD_PARENT(pad)),
+							gst_structure_new(XLOOP_CACHE_READY, NULL)));
+		}
+		else if(!loop->cache_ready && loop->cache_limit && start == 0) {
+			AudioBin = gst_bin_get_by_name(GST_BIN(loop->PipeLine), "audio_bin");
+			if(AudioBin) {
+				g_print("Loop: clip has sound, not caching\n");
+				gst_object_unref(GST_OBJECT(AudioBin));
+				loop->cache_limit = 0;
+			}
+			else {
+				set_capturing(loop, TRUE);
+			}
+		}
+		g_static_mutex_unlock(&loop->lock);
+		break;
+	}
+	case GST_EVENT_FLUSH_STOP:
+		/* a seek broke the pass, start over at the next loop */
+		g_static_mutex_lock(&loop->lock);
+		if(loop->capturing) {
+			cache_clear(loop);
+			set_capturing(loop, FALSE);
+		}
+		g_static_mutex_unlock(&loop->lock);
+		break;
+	default:
+		break;
+	}
+
+	return TRUE;
+}
+
+void xloop_init(xLoop * loop, GstElement * PipeLine, guint cache_limit, xMemBudget * budget, xQos * qos)
+{
+	GstElement * VideoSink;
+
+	memset(loop, 0, sizeof(xLoop));
+	g_static_mutex_init(&loop->lock);
+	loop->PipeLine = PipeLine;
+	loop->budget = budget;
+	loop->qos = qos;
+	loop->frames = g_ptr_array_new();
+	loop->last_ts = GST_CLOCK_TIME_NONE;
+	loop->duration = GST_CLOCK_TIME_NONE;
+
+	/* the decoding pipeline keeps at least half of the budget */
+	loop->cache_limit = MIN(cache_limit, budget->total / 2);
+	if(!loop->cache_limit)
+		return;
+
+	VideoSink = gst_bin_get_by_name(GST_BIN(PipeLine), "video_sink");
+	if(!VideoSink) {
+		loop->cache_limit = 0;
+		return;
+	}
+
+	mem_budget_set_limit(budget, MEM_COMP_FRAME_CACHE, loop->cache_limit);
+	loop->pad = gst_element_get_static_pad(VideoSink, "sink");
+	loop->buffer_probe = gst_pad_add_buffer_probe(loop->pad, G_CALLBACK(cache_buffer_probe), loop);
+	loop->event_probe = gst_pad_add_event_probe(loop->pad, G_CALLBACK(cache_event_probe), loop);
+	gst_object_unref(GST_OBJECT(VideoSink));
+}
+
+/* returns TRUE when the cache is complete and xloop_replay() can take over */
+gboolean xloop_handle_message(xLoop * loop, GstMessage * msg)
+{
+	if(loop->replaying)
+		return FALSE;
+
+	switch(GST_MESSAGE_TYPE(msg)) {
+	case GST_MESSAGE_STATE_CHANGED:
+	{
+		GstState old, new, pending;
+
+		if(GST_MESSAGE_SRC(msg) != GST_OBJECT_CAST(loop->PipeLine) || loop->started)
+			break;
+
+		gst_message_parse_state_changed(msg, &old, &new, &pending);
+		if(old == GST_STATE_READY && new == GST_STATE_PAUSED) {
+			loop->started = TRUE;
+			segment_seek(loop->PipeLine, TRUE);
+		}
+		break;
+	}
+	case GST_MESSAGE_SEGMENT_DONE:
+		if(GST_MESSAGE_SRC(msg) == GST_OBJECT_CAST(loop->PipeLine))
+			segment_seek(loop->PipeLine, FALSE);
+		break;
+	case GST_MESSAGE_APPLICATION:
+		return gst_structure_has_name(gst_message_get_structure(msg), XLOOP_CACHE_READY);
+	default:
+		break;
+	}
+
+	return FALSE;
+}
+
+/* returns TRUE when playback goes on */
+gboolean xloop_handle_eos(xLoop * loop)
+{
+	if(loop->replaying)
+		return FALSE;
+
+	g_print("Loop: end of stream, restarting\n");
+
+	return segment_seek(loop->PipeLine, TRUE);
+}
+
+static void need_data(GstAppSrc * src, guint length, gpointer data)
+{
+	xLoop * loop = (xLoop *) data;
+	GstBuffer * frame, * buf;
+
+	g_static_mutex_lock(&loop->lock);
+	frame = GST_BUFFER(g_ptr_array_index(loop->frames, loop->next));
+
+	/* shares the cached data, only the timestamp differs */
+	buf = gst_buffer_create_sub(frame, 0, GST_BUFFER_SIZE(frame));
+	GST_BUFFER_TIMESTAMP(buf) = GST_BUFFER_TIMESTAMP(frame) + loop->pass * loop->duration - loop->start_ts;
+	GST_BUFFER_DURATION(buf) = GST_BUFFER_DURATION(frame);
+	gst_buffer_set_caps(buf, loop->caps);
+
+	if(++loop->next == loop->frames->len) {
+		loop->next = 0;
+		loop->pass++;
+	}
+	g_static_mutex_unlock(&loop->lock);
+
+	gst_app_src_push_buffer(src, buf);
+}
+
+static gboolean seek_data(GstAppSrc * src, guint64 offset, gpointer data)
+{
+	xLoop * loop = (xLoop *) data;
+	GstClockTime t;
+	guint i;
+
+	g_static_mutex_lock(&loop->lock);
+	t = offset + loop->start_ts;
+	loop->pass = t / loop->duration;
+	t %= loop->duration;
+
+	for(i = 0; i < loop->frames->len; i++) {
+		if(GST_BUFFER_TIMESTAMP(GST_BUFFER(g_ptr_array_index(loop->frames, i))) >= t)
+			break;
+	}
+	if(i == loop->frames->len) {
+		i = 0;
+		loop->pass++;
+	}
+	loop->next = i;
+	g_static_mutex_unlock(&loop->lock);
+
+	return TRUE;
+}
+
+/* gets what the replay needs without touching the decoding pipeline */
+gboolean xloop_replay_prepare(xLoop * loop)
+{
+	if(!loop->cache_ready)
+		return FALSE;
+
+	if(!loop->source)
+		loop->source = autoplug_factory_make("appsrc", "cache_source");
+	if(!loop->sink)
+		loop->sink = gst_bin_get_by_name(GST_BIN(loop->PipeLine), "video_sink");
+
+	return loop->source && loop->sink;
+}
+
+/*
+ * Moves the video sink from the decoding pipeline into a new pipeline fed
+ * from the cache and returns that. The sink is kept in its state meanwhile,
+ * so the window or the overlay stays up. The decoding pipeline is left for
+ * the caller to shut down. Does not fail once xloop_replay_prepare() did
+ * not.
+ */
+GstElement * xloop_replay(xLoop * loop)
+{
+	static GstAppSrcCallbacks callbacks = { need_data, NULL, seek_data };
+	GstElement * Replay, * Source = loop->source, * VideoSink = loop->sink;
+	GstObject * parent;
+	GstPad * peer;
+	guint i;
+
+	loop->source = NULL;
+	loop->sink = NULL;
+
+	gst_pad_remove_buffer_probe(loop->pad, loop->buffer_probe);
+	gst_pad_remove_event_probe(loop->pad, loop->event_probe);
+
+	/* nothing else paces the appsrc, the i.MX27 tuning has the sink not syncing */
+	g_object_set(G_OBJECT(VideoSink), "sync", TRUE, NULL);
+
+	gst_element_set_locked_state(VideoSink, TRUE);
+	peer = gst_pad_get_peer(loop->pad);
+	if(peer) {
+		gst_pad_unlink(peer, loop->pad);
+		gst_object_unref(GST_OBJECT(peer));
+	}
+	parent = gst_object_get_parent(GST_OBJECT(VideoSink));
+	gst_bin_remove(GST_BIN(parent), VideoSink);
+	gst_object_unref(parent);
+
+	gst_app_src_set_caps(GST_APP_SRC(Source), loop->caps);
+	gst_app_src_set_stream_type(GST_APP_SRC(Source), GST_APP_STREAM_TYPE_SEEKABLE);
+	gst_app_src_set_max_bytes(GST_APP_SRC(Source), GST_BUFFER_SIZE(GST_BUFFER(g_ptr_array_index(loop->frames, 0))));
+	g_object_set(G_OBJECT(Source), "format", GST_FORMAT_TIME, NULL);
+	gst_app_src_set_callbacks(GST_APP_SRC(Source), &callbacks, loop, NULL);
+
+	Replay = gst_pipeline_new("replay");
+	gst_bin_add_many(GST_BIN(Replay), Source, VideoSink, NULL);
+	gst_element_link(Source, VideoSink);
+	gst_element_set_locked_state(VideoSink, FALSE);
+	gst_object_unref(GST_OBJECT(VideoSink));
+
+	/* go on with the frame after the one on screen */
+	g_static_mutex_lock(&loop->lock);
+	for(i = 0; i < loop->frames->len; i++) {
+		if(GST_BUFFER_TIMESTAMP(GST_BUFFER(g_ptr_array_index(loop->frames, i))) > loop->last_ts)
+			break;
+	}
+	loop->next = i < loop->frames->len ? i : 0;
+	loop->start_ts = GST_BUFFER_TIMESTAMP(GST_BUFFER(g_ptr_array_index(loop->frames, loop->next)));
+	loop->pass = 0;
+	loop->PipeLine = Replay;
+	loop->replaying = TRUE;
+
+	mem_budget_set_limit(loop->budget, MEM_COMP_FRAME_CACHE, loop->cache_limit);
+	mem_budget_charge(loop->budget, MEM_COMP_FRAME_CACHE, loop->cache_size);
+	g_static_mutex_unlock(&loop->lock);
+
+	g_print("Loop: replaying from the frame cache, decoder stopped\n");
+
+	return Replay;
+}
+
+/* clip position to seek to in the current pipeline */
+GstClockTime xloop_seek_target(xLoop * loop, GstClockTime position)
+{
+	GstClockTime target;
+
+	if(!loop->replaying)
+		return position;
+
+	g_static_mutex_lock(&loop->lock);
+	target = position % loop->duration + loop->pass * loop->duration;
+	if(target < loop->start_ts)
+		target += loop->duration;
+	g_static_mutex_unlock(&loop->lock);
+
+	return target - loop->start_ts;
+}
+
+/* the replay timeline keeps growing, map it back onto the clip */
+void xloop_position(xLoop * loop, GstClockTime * position, GstClockTime * duration)
+{
+	if(!loop->replaying)
+		return;
+
+	*position = (*position + loop->start_ts) % loop->duration;
+	*duration = loop->duration;
+}
+
+void xloop_release(xLoop * loop)
+{
+	if(!loop->frames)
+		return;
+
+	if(loop->source)
+		gst_object_unref(GST_OBJECT(loop->source));
+	if(loop->sink)
+		gst_object_unref(GST_OBJECT(loop->sink));
+
+	if(loop->pad) {
+		if(!loop->replaying) {
+			gst_pad_remove_buffer_probe(loop->pad, loop->buffer_probe);
+			gst_pad_remove_event_probe(loop->pad, loop->event_probe);
+		}
+		gst_object_unref(GST_OBJECT(loop->pad));
+	}
+
+	g_static_mutex_lock(&loop->lock);
+	cache_clear(loop);
+	g_static_mutex_unlock(&loop->lock);
+	g_ptr_array_free(loop->frames, TRUE);
+	g_static_mutex_free(&loop->lock);
+
+	memset(loop, 0, sizeof(xLoop));
+}
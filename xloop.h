@@ -0,0 +1,57 @@
+/*
+ * xloop.h - seamless looping and decoded frame cache
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#ifndef XLOOP_H_
+#define XLOOP_H_
+
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <glib.h>
+
+#include "membudget.h"
+#include "xqos.h"
+
+typedef struct {
+	GstElement * PipeLine;
+	xMemBudget * budget;
+	xQos * qos;				/* kept from dropping frames while capturing */
+	gboolean started;		/* the first segment seek was done */
+	gboolean replaying;		/* PipeLine is the cache replay pipeline */
+
+	/* decoded frame cache, filled during one full pass */
+	guint cache_limit;
+	GstPad * pad;			/* video sink pad */
+	gulong buffer_probe;
+	gulong event_probe;
+	GstElement * source;	/* appsrc and sink, got ready before the swap */
+	GstElement * sink;
+
+	GStaticMutex lock;
+	GPtrArray * frames;
+	GstCaps * caps;
+	guint cache_size;
+	gboolean capturing;
+	gboolean cache_ready;
+	GstClockTime last_ts;	/* last frame the sink got */
+	GstClockTime duration;
+
+	/* replay, timestamps are frame ts - start_ts + pass * duration */
+	GstClockTime start_ts;
+	guint next;
+	guint64 pass;
+} xLoop;
+
+void xloop_init(xLoop * loop, GstElement * PipeLine, guint cache_limit, xMemBudget * budget, xQos * qos);
+gboolean xloop_handle_message(xLoop * loop, GstMessage * msg);
+gboolean xloop_handle_eos(xLoop * loop);
+gboolean xloop_replay_prepare(xLoop * loop);
+GstElement * xloop_replay(xLoop * loop);
+GstClockTime xloop_seek_target(xLoop * loop, GstClockTime position);
+void xloop_position(xLoop * loop, GstClockTime * position, GstClockTime * duration);
+void xloop_release(xLoop * loop);
+
+#endif /* XLOOP_H_ */
@@ -0,0 +1,428 @@
+/*
+ * xoverlay.c - pre-rendered text and logo overlay
+ *
+ * The text (built-in 8x8 font, scaled up, with a drop shadow) and the logo
+ * (a PAM file with alpha) are rendered once into a YUV image with an alpha
+ * plane for the luma and one for the chroma resolution, cropped to the
+ * pixels that are not transparent. Putting it on a frame is then only a
+ * blend of that rectangle, no rendering, colour conversion or subsampling
+ * per frame. That is what made textoverlay too slow for the ARM926.
+ *
+ * The colour conversion is BT.601 with video levels, matching the decoders.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "xoverlay.h"
+
+#define FOURCC(a, b, c, d)	((guint32) (a) | ((guint32) (b) << 8) | ((guint32) (c) << 16) | ((guint32) (d) << 24))
+#define FOURCC_YV12	FOURCC('Y', 'V', '1', '2')
+
+#define ROUND_UP_2(n)	(((n) + 1) & ~1)
+#define ROUND_UP_4(n)	(((n) + 3) & ~3)
+
+#define GLYPH_W		8
+#define GLYPH_H		8
+#define LOGO_GAP	8		/* between the logo and the text */
+#define LOGO_MAX	2048
+
+/* ASCII 0x20 - 0x7e, one byte per row, bit 0 is the leftmost pixel */
+static const guint8 font8x8[95][8] = {
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	/* ' ' */
+	{ 0x18, 0x3c, 0x3c, 0x18, 0x18, 0x00, 0x18, 0x00 },	/* '!' */
+	{ 0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	/* '"' */
+	{ 0x36, 0x36, 0x7f, 0x36, 0x7f, 0x36, 0x36, 0x00 },	/* '#' */
+	{ 0x0c, 0x3e, 0x03, 0x1e, 0x30, 0x1f, 0x0c, 0x00 },	/* '$' */
+	{ 0x00, 0x63, 0x33, 0x18, 0x0c, 0x66, 0x63, 0x00 },	/* '%' */
+	{ 0x1c, 0x36, 0x1c, 0x6e, 0x3b, 0x33, 0x6e, 0x00 },	/* '&' */
+	{ 0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00 },	/* ''' */
+	{ 0x18, 0x0c, 0x06, 0x06, 0x06, 0x0c, 0x18, 0x00 },	/* '(' */
+	{ 0x06, 0x0c, 0x18, 0x18, 0x18, 0x0c, 0x06, 0x00 },	/* ')' */
+	{ 0x00, 0x66, 0x3c, 0xff, 0x3c, 0x66, 0x00, 0x00 },	/* '*' */
+	{ 0x00, 0x0c, 0x0c, 0x3f, 0x0c, 0x0c, 0x00, 0x00 },	/* '+' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c, 0x06 },	/* ',' */
+	{ 0x00, 0x00, 0x00, 0x3f, 0x00, 0x00, 0x00, 0x00 },	/* '-' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c, 0x00 },	/* '.' */
+	{ 0x60, 0x30, 0x18, 0x0c, 0x06, 0x03, 0x01, 0x00 },	/* '/' */
+	{ 0x3e, 0x63, 0x73, 0x7b, 0x6f, 0x67, 0x3e, 0x00 },	/* '0' */
+	{ 0x0c, 0x0e, 0x0c, 0x0c, 0x0c, 0x0c, 0x3f, 0x00 },	/* '1' */
+	{ 0x1e, 0x33, 0x30, 0x1c, 0x06, 0x33, 0x3f, 0x00 },	/* '2' */
+	{ 0x1e, 0x33, 0x30, 0x1c, 0x30, 0x33, 0x1e, 0x00 },	/* '3' */
+	{ 0x38, 0x3c, 0x36, 0x33, 0x7f, 0x30, 0x78, 0x00 },	/* '4' */
+	{ 0x3f, 0x03, 0x1f, 0x30, 0x30, 0x33, 0x1e, 0x00 },	/* '5' */
+	{ 0x1c, 0x06, 0x03, 0x1f, 0x33, 0x33, 0x1e, 0x00 },	/* '6' */
+	{ 0x3f, 0x33, 0x30, 0x18, 0x0c, 0x0c, 0x0c, 0x00 },	/* '7' */
+	{ 0x1e, 0x33, 0x33, 0x1e, 0x33, 0x33, 0x1e, 0x00 },	/* '8' */
+	{ 0x1e, 0x33, 0x33, 0x3e, 0x30, 0x18, 0x0e, 0x00 },	/* '9' */
+	{ 0x00, 0x0c, 0x0c, 0x00, 0x00, 0x0c, 0x0c, 0x00 },	/* ':' */
+	{ 0x00, 0x0c, 0x0c, 0x00, 0x00, 0x0c, 0x0c, 0x06 },	/* ';' */
+	{ 0x18, 0x0c, 0x06, 0x03, 0x06, 0x0c, 0x18, 0x00 },	/* '<' */
+	{ 0x00, 0x00, 0x3f, 0x00, 0x00, 0x3f, 0x00, 0x00 },	/* '=' */
+	{ 0x06, 0x0c, 0x18, 0x30, 0x18, 0x0c, 0x06, 0x00 },	/* '>' */
+	{ 0x1e, 0x33, 0x30, 0x18, 0x0c, 0x00, 0x0c, 0x00 },	/* '?' */
+	{ 0x3e, 0x63, 0x7b, 0x7b, 0x7b, 0x03, 0x1e, 0x00 },	/* '@' */
+	{ 0x0c, 0x1e, 0x33, 0x33, 0x3f, 0x33, 0x33, 0x00 },	/* 'A' */
+	{ 0x3f, 0x66, 0x66, 0x3e, 0x66, 0x66, 0x3f, 0x00 },	/* 'B' */
+	{ 0x3c, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3c, 0x00 },	/* 'C' */
+	{ 0x1f, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1f, 0x00 },	/* 'D' */
+	{ 0x7f, 0x46, 0x16, 0x1e, 0x16, 0x46, 0x7f, 0x00 },	/* 'E' */
+	{ 0x7f, 0x46, 0x16, 0x1e, 0x16, 0x06, 0x0f, 0x00 },	/* 'F' */
+	{ 0x3c, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7c, 0x00 },	/* 'G' */
+	{ 0x33, 0x33, 0x33, 0x3f, 0x33, 0x33, 0x33, 0x00 },	/* 'H' */
+	{ 0x1e, 0x0c, 0x0c, 0x0c, 0x0c, 0x0c, 0x1e, 0x00 },	/* 'I' */
+	{ 0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1e, 0x00 },	/* 'J' */
+	{ 0x67, 0x66, 0x36, 0x1e, 0x36, 0x66, 0x67, 0x00 },	/* 'K' */
+	{ 0x0f, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7f, 0x00 },	/* 'L' */
+	{ 0x63, 0x77, 0x7f, 0x7f, 0x6b, 0x63, 0x63, 0x00 },	/* 'M' */
+	{ 0x63, 0x67, 0x6f, 0x7b, 0x73, 0x63, 0x63, 0x00 },	/* 'N' */
+	{ 0x1c, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1c, 0x00 },	/* 'O' */
+	{ 0x3f, 0x66, 0x66, 0x3e, 0x06, 0x06, 0x0f, 0x00 },	/* 'P' */
+	{ 0x1e, 0x33, 0x33, 0x33, 0x3b, 0x1e, 0x38, 0x00 },	/* 'Q' */
+	{ 0x3f, 0x66, 0x66, 0x3e, 0x36, 0x66, 0x67, 0x00 },	/* 'R' */
+	{ 0x1e, 0x33, 0x07, 0x0e, 0x38, 0x33, 0x1e, 0x00 },	/* 'S' */
+	{ 0x3f, 0x2d, 0x0c, 0x0c, 0x0c, 0x0c, 0x1e, 0x00 },	/* 'T' */
+	{ 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3f, 0x00 },	/* 'U' */
+	{ 0x33, 0x33, 0x33, 0x33, 0x33, 0x1e, 0x0c, 0x00 },	/* 'V' */
+	{ 0x63, 0x63, 0x63, 0x6b, 0x7f, 0x77, 0x63, 0x00 },	/* 'W' */
+	{ 0x63, 0x63, 0x36, 0x1c, 0x1c, 0x36, 0x63, 0x00 },	/* 'X' */
+	{ 0x33, 0x33, 0x33, 0x1e, 0x0c, 0x0c, 0x1e, 0x00 },	/* 'Y' */
+	{ 0x7f, 0x63, 0x31, 0x18, 0x4c, 0x66, 0x7f, 0x00 },	/* 'Z' */
+	{ 0x1e, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1e, 0x00 },	/* '[' */
+	{ 0x03, 0x06, 0x0c, 0x18, 0x30, 0x60, 0x40, 0x00 },	/* '\' */
+	{ 0x1e, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1e, 0x00 },	/* ']' */
+	{ 0x08, 0x1c, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00 },	/* '^' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff },	/* '_' */
+	{ 0x0c, 0x0c, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00 },	/* '`' */
+	{ 0x00, 0x00, 0x1e, 0x30, 0x3e, 0x33, 0x6e, 0x00 },	/* 'a' */
+	{ 0x07, 0x06, 0x06, 0x3e, 0x66, 0x66, 0x3b, 0x00 },	/* 'b' */
+	{ 0x00, 0x00, 0x1e, 0x33, 0x03, 0x33, 0x1e, 0x00 },	/* 'c' */
+	{ 0x38, 0x30, 0x30, 0x3e, 0x33, 0x33, 0x6e, 0x00 },	/* 'd' */
+	{ 0x00, 0x00, 0x1e, 0x33, 0x3f, 0x03, 0x1e, 0x00 },	/* 'e' */
+	{ 0x1c, 0x36, 0x06, 0x0f, 0x06, 0x06, 0x0f, 0x00 },	/* 'f' */
+	{ 0x00, 0x00, 0x6e, 0x33, 0x33, 0x3e, 0x30, 0x1f },	/* 'g' */
+	{ 0x07, 0x06, 0x36, 0x6e, 0x66, 0x66, 0x67, 0x00 },	/* 'h' */
+	{ 0x0c, 0x00, 0x0e, 0x0c, 0x0c, 0x0c, 0x1e, 0x00 },	/* 'i' */
+	{ 0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1e },	/* 'j' */
+	{ 0x07, 0x06, 0x66, 0x36, 0x1e, 0x36, 0x67, 0x00 },	/* 'k' */
+	{ 0x0e, 0x0c, 0x0c, 0x0c, 0x0c, 0x0c, 0x1e, 0x00 },	/* 'l' */
+	{ 0x00, 0x00, 0x33, 0x7f, 0x7f, 0x6b, 0x63, 0x00 },	/* 'm' */
+	{ 0x00, 0x00, 0x1f, 0x33, 0x33, 0x33, 0x33, 0x00 },	/* 'n' */
+	{ 0x00, 0x00, 0x1e, 0x33, 0x33, 0x33, 0x1e, 0x00 },	/* 'o' */
+	{ 0x00, 0x00, 0x3b, 0x66, 0x66, 0x3e, 0x06, 0x0f },	/* 'p' */
+	{ 0x00, 0x00, 0x6e, 0x33, 0x33, 0x3e, 0x30, 0x78 },	/* 'q' */
+	{ 0x00, 0x00, 0x3b, 0x6e, 0x66, 0x06, 0x0f, 0x00 },	/* 'r' */
+	{ 0x00, 0x00, 0x3e, 0x03, 0x1e, 0x30, 0x1f, 0x00 },	/* 's' */
+	{ 0x08, 0x0c, 0x3e, 0x0c, 0x0c, 0x2c, 0x18, 0x00 },	/* 't' */
+	{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6e, 0x00 },	/* 'u' */
+	{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x1e, 0x0c, 0x00 },	/* 'v' */
+	{ 0x00, 0x00, 0x63, 0x6b, 0x7f, 0x7f, 0x36, 0x00 },	/* 'w' */
+	{ 0x00, 0x00, 0x63, 0x36, 0x1c, 0x36, 0x63, 0x00 },	/* 'x' */
+	{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x3e, 0x30, 0x1f },	/* 'y' */
+	{ 0x00, 0x00, 0x3f, 0x19, 0x0c, 0x26, 0x3f, 0x00 },	/* 'z' */
+	{ 0x38, 0x0c, 0x0c, 0x07, 0x0c, 0x0c, 0x38, 0x00 },	/* '{' */
+	{ 0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00 },	/* '|' */
+	{ 0x07, 0x0c, 0x0c, 0x38, 0x0c, 0x0c, 0x07, 0x00 },	/* '}' */
+	{ 0x6e, 0x3b, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	/* '~' */
+};
+
+/* P7 with DEPTH 3 (RGB) or 4 (RGB_ALPHA) and MAXVAL 255, e.g. from pngtopam -alphapam */
+static guint8 * load_pam(const gchar * path, gint * width, gint * height)
+{
+	gchar * data, * p, * end;
+	gsize len;
+	gint w = 0, h = 0, depth = 0, maxval = 0, i;
+	gboolean header = FALSE;
+	guint8 * rgba = NULL;
+
+	if(!g_file_get_contents(path, &data, &len, NULL)) {
+		g_print("Overlay: cannot read logo %s\n", path);
+		return NULL;
+	}
+
+	p = data;
+	end = data + len;
+	if(len < 3 || strncmp(p, "P7\n", 3))
+		goto out;
+
+	for(p += 3; p < end && !header; ) {
+		gchar * nl = memchr(p, '\n', end - p);
+
+		if(!nl)
+			goto out;
+		*nl = '\0';
+		if(!strcmp(p, "ENDHDR"))
+			header = TRUE;
+		else if(!strncmp(p, "WIDTH ", 6))
+			w = atoi(p + 6);
+		else if(!strncmp(p, "HEIGHT ", 7))
+			h = atoi(p + 7);
+		else if(!strncmp(p, "DEPTH ", 6))
+			depth = atoi(p + 6);
+		else if(!strncmp(p, "MAXVAL ", 7))
+			maxval = atoi(p + 7);
+		p = nl + 1;
+	}
+
+	if(!header || w <= 0 || h <= 0 || w > LOGO_MAX || h > LOGO_MAX ||
+			(depth != 3 && depth != 4) || maxval != 255 || end - p < w * h * depth)
+		goto out;
+
+	rgba = g_malloc(w * h * 4);
+	for(i = 0; i < w * h; i++) {
+		const guint8 * s = (const guint8 *) p + i * depth;
+
+		rgba[i * 4] = s[0];
+		rgba[i * 4 + 1] = s[1];
+		rgba[i * 4 + 2] = s[2];
+		rgba[i * 4 + 3] = depth == 4 ? s[3] : 0xff;
+	}
+	*width = w;
+	*height = h;
+
+out:
+	if(!rgba)
+		g_print("Overlay: %s is not an 8 bit RGB or RGB_ALPHA PAM\n", path);
+	g_free(data);
+
+	return rgba;
+}
+
+/* glyph index, UTF-8 continuation bytes draw nothing */
+static gint glyph_index(guchar c)
+{
+	if((c & 0xc0) == 0x80)
+		return -1;
+	if(c < 0x20 || c > 0x7e)
+		return '?' - 0x20;
+
+	return c - 0x20;
+}
+
+static gint text_glyphs(const gchar * text)
+{
+	gint n = 0;
+
+	for(; text && *text; text++) {
+		if(glyph_index(*text) >= 0)
+			n++;
+	}
+
+	return n;
+}
+
+static void draw_text(guint8 * canvas, gint stride, const gchar * text, gint x, gint y, gint scale, guint32 color)
+{
+	gint r, c, i, j;
+
+	for(; *text; text++) {
+		gint g = glyph_index(*text);
+
+		if(g < 0)
+			continue;
+		for(r = 0; r < GLYPH_H; r++) {
+			for(c = 0; c < GLYPH_W; c++) {
+				if(!(font8x8[g][r] & (1 << c)))
+					continue;
+				for(j = 0; j < scale; j++) {
+					guint8 * p = canvas + ((y + r * scale + j) * stride + x + c * scale) * 4;
+
+					for(i = 0; i < scale; i++, p += 4) {
+						p[0] = (color >> 16) & 0xff;
+						p[1] = (color >> 8) & 0xff;
+						p[2] = color & 0xff;
+						p[3] = 0xff;
+					}
+				}
+			}
+		}
+		x += GLYPH_W * scale;
+	}
+}
+
+/* RGBA at x, y, transparent outside the canvas so the crop can round up */
+static const guint8 * canvas_pixel(const guint8 * canvas, gint w, gint h, gint x, gint y)
+{
+	static const guint8 clear[4] = { 0, 0, 0, 0 };
+
+	if(x >= w || y >= h)
+		return clear;
+
+	return canvas + (y * w + x) * 4;
+}
+
+static void canvas_to_yuv(xOverlay * ov, const guint8 * canvas, gint w, gint h)
+{
+	gint x0 = w, y0 = h, x1 = 0, y1 = 0;
+	gint x, y, cw, ch;
+
+	for(y = 0; y < h; y++) {
+		for(x = 0; x < w; x++) {
+			if(!canvas[(y * w + x) * 4 + 3])
+				continue;
+			x0 = MIN(x0, x);
+			y0 = MIN(y0, y);
+			x1 = MAX(x1, x + 1);
+			y1 = MAX(y1, y + 1);
+		}
+	}
+	if(x0 >= x1)
+		return;
+
+	/* the luma starts word aligned for the skip kernel, the chroma needs even */
+	ov->bx = x0 & ~3;
+	ov->by = y0 & ~1;
+	ov->w = ROUND_UP_2(x1) - ov->bx;
+	ov->h = ROUND_UP_2(y1) - ov->by;
+	ov->stride = ROUND_UP_4(ov->w);
+	cw = ov->w / 2;
+	ch = ov->h / 2;
+	ov->cstride = ROUND_UP_4(cw);
+
+	ov->y = g_malloc0(ov->stride * ov->h);
+	ov->ay = g_malloc0(ov->stride * ov->h);
+	ov->u = g_malloc0(ov->cstride * ch);
+	ov->v = g_malloc0(ov->cstride * ch);
+	ov->ac = g_malloc0(ov->cstride * ch);
+
+	for(y = 0; y < ov->h; y++) {
+		for(x = 0; x < ov->w; x++) {
+			const guint8 * p = canvas_pixel(canvas, w, h, ov->bx + x, ov->by + y);
+
+			ov->y[y * ov->stride + x] = ((66 * p[0] + 129 * p[1] + 25 * p[2] + 128) >> 8) + 16;
+			ov->ay[y * ov->stride + x] = p[3];
+		}
+	}
+
+	/* alpha weighted, so the colour of transparent pixels does not bleed in */
+	for(y = 0; y < ch; y++) {
+		for(x = 0; x < cw; x++) {
+			gint usum = 0, vsum = 0, asum = 0, i;
+
+			for(i = 0; i < 4; i++) {
+				const guint8 * p = canvas_pixel(canvas, w, h, ov->bx + x * 2 + (i & 1), ov->by + y * 2 + (i >> 1));
+				gint u = ((-38 * p[0] - 74 * p[1] + 112 * p[2] + 128) >> 8) + 128;
+				gint v = ((112 * p[0] - 94 * p[1] - 18 * p[2] + 128) >> 8) + 128;
+
+				usum += u * p[3];
+				vsum += v * p[3];
+				asum += p[3];
+			}
+			ov->u[y * ov->cstride + x] = asum ? usum / asum : 128;
+			ov->v[y * ov->cstride + x] = asum ? vsum / asum : 128;
+			ov->ac[y * ov->cstride + x] = (asum + 2) / 4;
+		}
+	}
+}
+
+/*
+ * Logo on the left, text right of it and vertically centred. color is
+ * 0xRRGGBB. Returns FALSE if the logo could not be loaded, the text is
+ * rendered anyway.
+ */
+gboolean xoverlay_render(xOverlay * ov, const gchar * text, const gchar * logo, gint scale, guint32 color)
+{
+	guint8 * logo_rgba = NULL;
+	guint8 * canvas;
+	gint lw = 0, lh = 0, tw = 0, th = 0, w, h, y, shadow, glyphs;
+	gboolean ok = TRUE;
+
+	xoverlay_free(ov);
+
+	scale = CLAMP(scale, 1, 8);
+	shadow = MAX(scale / 2, 1);
+
+	if(logo && *logo) {
+		logo_rgba = load_pam(logo, &lw, &lh);
+		ok = logo_rgba != NULL;
+	}
+	glyphs = text_glyphs(text);
+	if(glyphs) {
+		tw = glyphs * GLYPH_W * scale + shadow;
+		th = GLYPH_H * scale + shadow;
+	}
+
+	w = lw + (lw && tw ? LOGO_GAP : 0) + tw;
+	h = MAX(lh, th);
+	if(!w || !h) {
+		g_free(logo_rgba);
+		return ok;
+	}
+
+	canvas = g_malloc0(w * h * 4);
+	for(y = 0; y < lh; y++)
+		memcpy(canvas + (y + (h - lh) / 2) * w * 4, logo_rgba + y * lw * 4, lw * 4);
+	if(glyphs) {
+		draw_text(canvas, w, text, w - tw + shadow, (h - th) / 2 + shadow, scale, 0x000000);
+		draw_text(canvas, w, text, w - tw, (h - th) / 2, scale, color);
+	}
+
+	canvas_to_yuv(ov, canvas, w, h);
+
+	g_free(canvas);
+	g_free(logo_rgba);
+
+	return ok;
+}
+
+/*
+ * Blends the cached overlay into an I420 or YV12 frame, its top left corner
+ * at x, y (rounded down to even), clipped to the frame. Only the rows and
+ * columns of the crop are touched.
+ */
+void xoverlay_blend(const xOverlay * ov, const xBlendKernels * k, guint8 * frame, guint32 fourcc,
+		gint width, gint height, gint x, gint y)
+{
+	gint ystride = ROUND_UP_4(width);
+	gint cstride = ROUND_UP_4(ROUND_UP_2(width) / 2);
+	guint8 * fu = frame + ystride * ROUND_UP_2(height);
+	guint8 * fv = fu + cstride * (ROUND_UP_2(height) / 2);
+	gint x0, y0, x1, y1, row, n;
+
+	if(!ov->w)
+		return;
+
+	if(fourcc == FOURCC_YV12) {
+		guint8 * t = fu;
+		fu = fv;
+		fv = t;
+	}
+
+	x = (x & ~1) + ov->bx;
+	y = (y & ~1) + ov->by;
+	x0 = MAX(x, 0);
+	y0 = MAX(y, 0);
+	x1 = MIN(x + ov->w, width);
+	y1 = MIN(y + ov->h, height);
+	if(x0 >= x1 || y0 >= y1)
+		return;
+
+	for(row = y0; row < y1; row++) {
+		gint off = (row - y) * ov->stride + (x0 - x);
+
+		k->blend_row(frame + row * ystride + x0, ov->y + off, ov->ay + off, x1 - x0);
+	}
+
+	/* x, y, x0 and y0 are all even here */
+	n = (x1 + 1) / 2 - x0 / 2;
+	for(row = y0 / 2; row < (y1 + 1) / 2; row++) {
+		gint off = (row - y / 2) * ov->cstride + (x0 - x) / 2;
+
+		k->blend_row(fu + row * cstride + x0 / 2, ov->u + off, ov->ac + off, n);
+		k->blend_row(fv + row * cstride + x0 / 2, ov->v + off, ov->ac + off, n);
+	}
+}
+
+void xoverlay_free(xOverlay * ov)
+{
+	g_free(ov->y);
+	g_free(ov->ay);
+	g_free(ov->u);
+	g_free(ov->v);
+	g_free(ov->ac);
+	memset(ov, 0, sizeof(xOverlay));
+}
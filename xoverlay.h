@@ -0,0 +1,34 @@
+/*
+ * xoverlay.h - pre-rendered text and logo overlay
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#ifndef XOVERLAY_H_
+#define XOVERLAY_H_
+
+#include <glib.h>
+
+#include "xblend.h"
+
+/*
+ * The rendered overlay in I420 layout with an alpha plane per resolution,
+ * cropped to the visible pixels. bx/by is where the crop starts relative to
+ * the overlay position, all of it even so the chroma lines up.
+ */
+typedef struct {
+	gint bx, by;
+	gint w, h;				/* luma, 0 when there is nothing to draw */
+	gint stride;			/* of y and ay, multiple of 4 */
+	gint cstride;			/* of u, v and ac */
+	guint8 * y, * ay;
+	guint8 * u, * v, * ac;
+} xOverlay;
+
+gboolean xoverlay_render(xOverlay * ov, const gchar * text, const gchar * logo, gint scale, guint32 color);
+void xoverlay_blend(const xOverlay * ov, const xBlendKernels * k, guint8 * frame, guint32 fourcc,
+		gint width, gint height, gint x, gint y);
+void xoverlay_free(xOverlay * ov);
+
+#endif /* XOVERLAY_H_ */
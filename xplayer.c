@@ -0,0 +1,988 @@
+/*
+ * xplayer.c - embeddable player instance
+ *
+ * Every instance owns a pipeline and a thread running its own main context.
+ * The bus watch and the periodic sources of the instance are attached to
+ * that context, and the API calls are marshalled onto it, so the pipeline
+ * is only ever driven from one thread. Events are delivered from the
+ * instance thread as well. The position and QoS getters are the exception:
+ * they read the modules under their own locks in the calling thread, so
+ * polling them never waits for a state change or a restart.
+ *
+ * The element factories are looked up through the process-wide cache in
+ * autoplugger.c, so creating another instance does not walk the registry.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#include <stdio.h>
+#include <gst/gst.h>
+#include <glib.h>
+
+#include "debug.h"
+#include "xplayer.h"
+#include "autoplugger.h"
+#include "xaudio.h"
+#include "membudget.h"
+#include "plugin.h"
+#include "xposition.h"
+#include "xrecovery.h"
+#include "xqos.h"
+#include "xloop.h"
+#include "xtrack.h"
+
+struct _xPlayer {
+	GstElement * PipeLine;
+	xPlayerConfig config;
+	xPlayerEventFunc func;
+	gpointer user_data;
+
+	GMainContext * context;
+	GMainLoop * loop;
+	GThread * thread;
+	GSource * bus_source;
+	GMutex * lock;
+	GCond * cond;
+
+	volatile gboolean play;
+	GStaticMutex swap_lock;	/* attached, for the getters outside the instance thread */
+	gboolean attached;		/* the modules below follow player->PipeLine */
+	xMemBudget budget;
+	xPosition position;
+	xRecovery recovery;
+	xQos qos;
+	xLoop looping;
+	xTrack track;
+};
+
+static void emit(xPlayer * player, xPlayerEvent event, const gchar * detail)
+{
+	if(player->func)
+		player->func(player, event, detail, player->user_data);
+}
+
+static void print_tag(const GstTagList * list, const gchar * tag, gpointer unused)
+{
+  gint i, count;
+
+  count = gst_tag_list_get_tag_size (list, tag);
+
+  for (i = 0; i < count; i++) {
+    gchar *str;
+
+    if (gst_tag_get_type (tag) == G_TYPE_STRING) {
+      if (!gst_tag_list_get_string_index (list, tag, i, &str))
+        g_assert_not_reached ();
+    } else if (gst_tag_get_type (tag) == GST_TYPE_BUFFER) {
+      GstBuffer *img;
+
+      img = gst_value_get_buffer (gst_tag_list_get_value_index (list, tag, i));
+      if (img) {
+        gchar *caps_str;
+
+        caps_str = GST_BUFFER_CAPS (img) ?
+            gst_caps_to_string (GST_BUFFER_CAPS (img)) : g_strdup ("unknown");
+        str = g_strdup_printf ("buffer of %u bytes, type: %s",
+            GST_BUFFER_SIZE (img), caps_str);
+        g_free (caps_str);
+      } else {
+        str = g_strdup ("NULL buffer");
+      }
+    } else {
+      str =
+          g_strdup_value_contents (gst_tag_list_get_value_index (list, tag, i));
+    }
+
+    if (i == 0) {
+      g_print ("%16s: %s\n", gst_tag_get_nick (tag), str);
+    } else {
+      g_print ("%16s: %s\n", "", str);
+    }
+
+    g_free (str);
+  }
+}
+
+static void schedule_replay(xPlayer * player);
+
+static int bus_call(GstBus * bus, GstMessage * msg, void * data)
+{
+	xPlayer * player = (xPlayer *) data;
+	gboolean buffering = FALSE;
+
+	// g_print(">>> BUS CALL !!! <<<\n");
+
+	xpos_handle_message(&player->position, msg);
+	if(xrec_handle_message(&player->recovery, msg))
+		emit(player, XPLAYER_EVENT_RECOVERED, NULL);
+	if(player->config.loop && xloop_handle_message(&player->looping, msg))
+		schedule_replay(player);
+
+	switch(GST_MESSAGE_TYPE(msg))
+	{
+	case GST_MESSAGE_EOS:
+		/* the queue and the demuxer push EOS after the error being recovered from */
+		if(xrec_pending(&player->recovery)) {
+			g_print("End of stream while recovering, ignored\n");
+			break;
+		}
+		g_print("End of stream\n");
+		if(player->config.loop && xloop_handle_eos(&player->looping))
+			break;
+		player->play = FALSE;
+		emit(player, XPLAYER_EVENT_EOS, NULL);
+		break;
+	case GST_MESSAGE_ERROR:
+	{
+		char * debug;
+		GError * error;
+
+		gst_message_parse_error(msg, &error, &debug);
+		g_free(debug);
+
+		g_printerr("Error %s\n", error->message);
+		if(xrec_handle_error(&player->recovery, msg, error)) {
+			g_error_free(error);
+			break;
+		}
+		player->play = FALSE;
+		emit(player, XPLAYER_EVENT_ERROR, error->message);
+		g_error_free(error);
+		break;
+	}
+	case GST_MESSAGE_NEW_CLOCK:
+	{
+		GstClock *clock;
+
+		gst_message_parse_new_clock(msg, &clock);
+
+		g_print("New clock: %s\n", (clock ? GST_OBJECT_NAME(clock) : "NULL"));
+		break;
+	}
+	case GST_MESSAGE_CLOCK_LOST:
+		/* disabled for now as it caused problems with rtspsrc. We need to fix
+		 * rtspsrc first, then release -good before we can reenable this again
+		 */
+		g_print("Clock lost, selecting a new one\n");
+		gst_element_set_state(player->PipeLine, GST_STATE_PAUSED);
+		gst_element_set_state(player->PipeLine, GST_STATE_PLAYING);
+		break;
+	case GST_MESSAGE_ELEMENT:
+		g_print("ELEMENT MESSAGE\n");
+		break;
+	case GST_MESSAGE_TAG:
+	{
+		GstTagList *tags;
+
+		if (GST_IS_ELEMENT (GST_MESSAGE_SRC (msg)))
+		{
+			g_print("FOUND TAG      : found by element \"%s\".\n", GST_MESSAGE_SRC_NAME (msg));
+		}
+		else if (GST_IS_PAD (GST_MESSAGE_SRC (msg)))
+		{
+			g_print("FOUND TAG      : found by pad \"%s:%s\".\n", GST_DEBUG_PAD_NAME (GST_MESSAGE_SRC (msg)));
+		}
+		else if (GST_IS_OBJECT (GST_MESSAGE_SRC (msg)))
+		{
+			g_print("FOUND TAG      : found by object \"%s\".\n", GST_MESSAGE_SRC_NAME (msg));
+		}
+		else
+		{
+			g_print("FOUND TAG\n");
+		}
+
+		gst_message_parse_tag(msg, &tags);
+		gst_tag_list_foreach(tags, print_tag, NULL);
+		gst_tag_list_free(tags);
+	}
+		break;
+	case GST_MESSAGE_INFO:
+	{
+		GError *gerror;
+		gchar *debug;
+		gchar *name = gst_object_get_path_string(GST_MESSAGE_SRC (msg));
+
+		gst_message_parse_info(msg, &gerror, &debug);
+		if (debug)
+		{
+			g_print("INFO:\n%s\n", debug);
+		}
+		g_error_free(gerror);
+		g_free(debug);
+		g_free(name);
+		break;
+	}
+	case GST_MESSAGE_WARNING:
+	{
+		GError *gerror;
+		gchar *debug;
+		gchar *name = gst_object_get_path_string(GST_MESSAGE_SRC (msg));
+
+		/* dump graph on warning */
+		GST_DEBUG_BIN_TO_DOT_FILE_WITH_TS (GST_BIN (player->PipeLine),
+				GST_DEBUG_GRAPH_SHOW_ALL, "gst-launch.warning");
+
+		gst_message_parse_warning(msg, &gerror, &debug);
+		g_print("WARNING: from element %s: %s\n", name, gerror->message);
+		if (debug)
+		{
+			g_print("Additional debug info:\n%s\n", debug);
+		}
+		g_error_free(gerror);
+		g_free(debug);
+		g_free(name);
+		break;
+	}
+	case GST_MESSAGE_STATE_CHANGED:
+	{
+		GstState old, new, pending;
+
+		gst_message_parse_state_changed(msg, &old, &new, &pending);
+
+		/* we only care about pipeline state change messages */
+		if (GST_MESSAGE_SRC (msg) != GST_OBJECT_CAST (player->PipeLine))
+			break;
+
+		/* dump graph for pipeline state changes */
+		{
+			gchar *dump_name = g_strdup_printf("gst-launch.%s_%s", gst_element_state_get_name(old), gst_element_state_get_name(new));
+			GST_DEBUG_BIN_TO_DOT_FILE_WITH_TS (GST_BIN (player->PipeLine),
+					GST_DEBUG_GRAPH_SHOW_ALL, dump_name);
+			g_free(dump_name);
+		}
+
+		if(new == GST_STATE_PAUSED && old == GST_STATE_READY)
+			xaudio_report(player->PipeLine);
+
+		if(new == GST_STATE_PLAYING)
+			emit(player, XPLAYER_EVENT_PLAYING, NULL);
+		else if(new == GST_STATE_PAUSED && old == GST_STATE_PLAYING)
+			emit(player, XPLAYER_EVENT_PAUSED, NULL);
+
+		/* ignore when we are buffering since then we mess with the states
+		 * ourselves. */
+		if (buffering)
+		{
+			g_print("Prerolled, waiting for buffering to finish...\n");
+			break;
+		}
+		/* else not an interesting message */
+		break;
+	}
+	case GST_MESSAGE_BUFFERING:
+	{
+		gint percent;
+
+		gst_message_parse_buffering(msg, &percent);
+		g_print("%s %d%%  \r", "buffering...", percent);
+		break;
+	}
+	case GST_MESSAGE_LATENCY:
+	{
+		g_print("Redistribute latency...\n");
+		gst_bin_recalculate_latency(GST_BIN (player->PipeLine));
+		break;
+	}
+	case GST_MESSAGE_REQUEST_STATE:
+	{
+		GstState state;
+		gchar *name = gst_object_get_path_string(GST_MESSAGE_SRC (msg));
+
+		gst_message_parse_request_state(msg, &state);
+
+		g_print("Setting state to %s as requested by %s...\n", gst_element_state_get_name(state), name);
+
+		gst_element_set_state(player->PipeLine, state);
+
+		g_free(name);
+		break;
+	}
+	case GST_MESSAGE_APPLICATION:
+	{
+		const GstStructure *s;
+
+		s = gst_message_get_structure(msg);
+
+		if (gst_structure_has_name(s, "GstLaunchInterrupt"))
+		{
+			/* this application message is posted when we caught an interrupt and
+			 * we need to stop the pipeline. */
+
+			g_print("Interrupt: Stopping pipeline ...\n");
+		}
+	}
+	case GST_MESSAGE_STREAM_STATUS: {
+		GstStreamStatusType stype;
+		GstElement * owner;
+		gst_message_parse_stream_status(msg, &stype, &owner);
+		g_print("Stream status: %d\n", stype);
+	}
+		break;
+	case GST_MESSAGE_ASYNC_DONE:
+		g_print("Async done.\n");
+		break;
+	default:
+		g_print("GST MESSAGE: %d\n", GST_MESSAGE_TYPE(msg));
+		break;
+	}
+
+	return TRUE;
+}
+
+/* route the demuxer pads by their caps, the audio branch is built to fit */
+static void on_pad_added(GstElement * element, GstPad * pad, void * data)
+{
+	xPlayer * player = (xPlayer *) data;
+	GstElement * bin = NULL;
+	GstPad * sinkpad;
+	GstCaps * caps;
+	const gchar * media;
+
+	caps = gst_pad_get_caps(pad);
+	if(gst_caps_is_empty(caps) || gst_caps_is_any(caps)) {
+		gst_caps_unref(caps);
+		return;
+	}
+	media = gst_structure_get_name(gst_caps_get_structure(caps, 0));
+
+	if(g_str_has_prefix(media, "video/")) {
+		bin = gst_bin_get_by_name(GST_BIN(player->PipeLine), "video_bin");
+	}
+	else if(g_str_has_prefix(media, "audio/") && player->config.audio) {
+		/* first audio stream only, a restarted demuxer links the existing bin again */
+		bin = gst_bin_get_by_name(GST_BIN(player->PipeLine), "audio_bin");
+		if(bin) {
+			sinkpad = gst_element_get_static_pad(bin, "sink");
+			if(gst_pad_is_linked(sinkpad)) {
+				gst_object_unref(GST_OBJECT(bin));
+				bin = NULL;
+			}
+			gst_object_unref(sinkpad);
+		}
+		else {
+			bin = xaudio_bin_new(caps, player->config.audio_buffer_time, player->config.audio_latency_time);
+			if(bin) {
+				gst_object_ref(GST_OBJECT(bin));
+				gst_bin_add(GST_BIN(player->PipeLine), bin);
+			}
+		}
+	}
+
+	if(!bin) {
+		g_print("Dynamic pad %s:%s (%s) not linked\n", GST_DEBUG_PAD_NAME(pad), media);
+		gst_caps_unref(caps);
+		return;
+	}
+
+	g_print("Dynamic pad created, linking %s:%s to %s\n", GST_DEBUG_PAD_NAME(pad), GST_OBJECT_NAME(bin));
+	sinkpad = gst_element_get_static_pad(bin, "sink");
+	if(gst_pad_link(pad, sinkpad) != GST_PAD_LINK_OK)
+		g_print("Linking %s:%s failed\n", GST_DEBUG_PAD_NAME(pad));
+	gst_object_unref(sinkpad);
+	gst_element_sync_state_with_parent(bin);
+
+	gst_object_unref(GST_OBJECT(bin));
+	gst_caps_unref(caps);
+}
+
+static inline void add_static_ghost_pad(GstElement * bin, GstElement * el, char * name)
+{
+	GstPad * pad;
+
+	pad = gst_element_get_static_pad(el, name);
+	gst_element_add_pad(bin, gst_ghost_pad_new(name, pad));
+	gst_object_unref(GST_OBJECT(pad));
+}
+
+static gboolean seek_to_time(GstElement *pipeline, gint64 time_nanoseconds, gboolean segment)
+{
+	GstSeekFlags flags = GST_SEEK_FLAG_FLUSH;
+
+	/* keeps a segment loop going */
+	if (segment)
+		flags |= GST_SEEK_FLAG_SEGMENT;
+
+	if (!gst_element_seek(pipeline, 1.0, GST_FORMAT_TIME, flags, GST_SEEK_TYPE_SET, time_nanoseconds, GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE)) {
+		g_print("Seek failed!\n");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+enum MfwGstVpuDecCodecs {
+	std_mpeg4,
+	std_h263,
+	std_avc,
+};
+
+#define VIDEO_QUEUE	1
+
+#ifndef MACH_IMX27
+/* Xv when the server has it, otherwise ximagesink behind our own converter */
+static GstElement * getDisplaySink(const xPlayerConfig * config, GstElement ** VideoConv)
+{
+	GstElement * VideoSink = NULL;
+
+	*VideoConv = NULL;
+
+	if(!config->video_scale) {
+		VideoSink = autoplug_factory_make("xvimagesink", "video_sink");
+		if(VideoSink) {
+			if(gst_element_set_state(VideoSink, GST_STATE_READY) != GST_STATE_CHANGE_FAILURE) {
+				gst_element_set_state(VideoSink, GST_STATE_NULL);
+				return VideoSink;
+			}
+			g_print("Xv not available, converting in software\n");
+			gst_element_set_state(VideoSink, GST_STATE_NULL);
+			gst_object_unref(GST_OBJECT(VideoSink));
+		}
+	}
+
+	*VideoConv = autoplug_factory_make("xscale", "video_convertor");
+	if(!*VideoConv)
+		return NULL;
+	if(config->video_scale)
+		g_object_set(G_OBJECT(*VideoConv), "width", config->tune.display_width, "height", config->tune.display_height, NULL);
+
+	VideoSink = autoplug_factory_make("ximagesink", "video_sink");
+	if(!VideoSink) {
+		gst_object_unref(GST_OBJECT(*VideoConv));
+		*VideoConv = NULL;
+	}
+
+	return VideoSink;
+}
+#endif
+
+static GstElement * getVideoPlayBin(const xPlayerConfig * config, enum MfwGstVpuDecCodecs codec)
+{
+	GstElement * VideoBin = NULL;
+#ifdef VIDEO_QUEUE
+	GstElement * VideoQueue0 = autoplug_factory_make("queue", "video_queue0");
+#endif
+	// GstElement * VideoQueue1 = autoplug_factory_make("queue", "video_queue1");
+#ifdef MACH_IMX27
+	GstElement * VideoDec = autoplug_factory_make("mfw_vpudecoder", "video_decoder"); // ffdec_mpeg4
+	GstElement * VideoSink = NULL;
+	GstElement * VideoConv = NULL;
+#else
+	GstElement * VideoDec = autoplug_factory_make("ffdec_mpeg4", "video_decoder");
+	GstElement * VideoSink = NULL;
+	GstElement * VideoConv = NULL;
+#endif
+	GstElement * VideoOverlay = NULL;
+	GstElement * Upstream;
+
+	if(config->headless)
+		VideoSink = autoplug_factory_make("fakesink", "video_sink");
+	else
+#ifdef MACH_IMX27
+		VideoSink = autoplug_factory_make("mfw_v4lsink", "video_sink"); // xvimagesink
+#else
+		VideoSink = getDisplaySink(config, &VideoConv);
+#endif
+
+	/* rendered once, every frame only gets the cached rectangle blended in */
+	if(config->overlay_text || config->overlay_logo)
+		VideoOverlay = autoplug_factory_make("xoverlay", "video_overlay");
+
+#ifdef VIDEO_QUEUE
+	if(VideoQueue0 && VideoDec && VideoSink) {
+#else
+	if(VideoDec && VideoSink) {
+#endif
+		VideoBin = gst_bin_new("video_bin");
+#ifdef VIDEO_QUEUE
+		g_object_set(G_OBJECT(VideoQueue0), "max-size-buffers", config->tune.video_queue_buffers, NULL);
+		g_object_set(G_OBJECT(VideoQueue0), "max-size-time", config->tune.video_queue_time, NULL);
+		g_object_set(G_OBJECT(VideoQueue0), "max-size-bytes", config->tune.video_queue_bytes, NULL);
+#endif
+#ifdef MACH_IMX27
+		g_object_set(G_OBJECT(VideoDec), "codec-type", codec, NULL);
+		if(!config->headless) {
+			g_object_set(G_OBJECT(VideoSink), "disp-width", config->tune.display_width, "disp-height", config->tune.display_height, NULL);
+			g_object_set(G_OBJECT(VideoSink), "axis-left", config->display_x, "axis-top", config->display_y, NULL);
+		}
+#else
+		g_object_set(G_OBJECT(VideoSink), "async", TRUE, NULL);
+#endif
+		g_object_set(G_OBJECT(VideoSink), "sync", config->tune.sink_sync, NULL);
+		g_object_set(G_OBJECT(VideoSink), "max-lateness", config->tune.max_lateness, NULL);
+		if(VideoOverlay)
+			g_object_set(G_OBJECT(VideoOverlay), "text", config->overlay_text, "logo", config->overlay_logo, NULL);
+#ifdef VIDEO_QUEUE
+		gst_bin_add_many(GST_BIN(VideoBin), VideoQueue0, VideoDec, VideoSink, NULL);
+		gst_element_link(VideoQueue0, VideoDec);
+		add_static_ghost_pad(VideoBin, VideoQueue0, "sink");
+#else
+		gst_bin_add_many(GST_BIN(VideoBin), VideoDec, VideoSink, NULL);
+		add_static_ghost_pad(VideoBin, VideoDec, "sink");
+#endif
+		Upstream = VideoDec;
+		if(VideoOverlay) {
+			gst_bin_add(GST_BIN(VideoBin), VideoOverlay);
+			gst_element_link(Upstream, VideoOverlay);
+			Upstream = VideoOverlay;
+		}
+		if(VideoConv) {
+			gst_bin_add(GST_BIN(VideoBin), VideoConv);
+			gst_element_link_many(Upstream, VideoConv, VideoSink, NULL);
+		}
+		else {
+			gst_element_link(Upstream, VideoSink);
+		}
+	}
+
+	return VideoBin;
+}
+
+static GstElement * initPipeLine(xPlayer * player, const gchar * name, int vcodec)
+{
+	const xPlayerConfig * config = &player->config;
+	gchar * Name;
+	GstElement * PipeLine = NULL;
+	GstElement * Source = NULL;
+	GstElement * Demuxer = NULL;
+	GstElement * VideoBin = NULL;
+
+	if(!(name && ((vcodec >= 0) || config->audio))) {
+		Name = NULL;
+		PipeLine = NULL;
+		return NULL;
+	}
+
+	Name = g_strdup(name);
+
+	if(!g_file_test(Name, G_FILE_TEST_EXISTS)) {
+		g_free(Name);
+		Name = NULL;
+		return NULL;
+	}
+
+	if(vcodec >= 0)
+		VideoBin = getVideoPlayBin(config, (enum MfwGstVpuDecCodecs)std_mpeg4);
+
+	PipeLine = gst_pipeline_new("pipeline");
+	Source = autoplug_factory_make("filesrc", "source");
+	Demuxer = autoplug_factory_make(config->demuxer, "avi_demuxer");
+
+	if(!(Source && Demuxer && (VideoBin || config->audio))) {
+		g_free(Name);
+		Name = NULL;
+		gst_object_unref(GST_OBJECT(Source));
+		gst_object_unref(GST_OBJECT(Demuxer));
+		gst_object_unref(GST_OBJECT(VideoBin));
+		return NULL;
+	}
+
+	g_object_set(G_OBJECT(Source), "location", Name, NULL);
+	g_object_set(G_OBJECT(Source), "use-mmap", TRUE, NULL);
+	g_object_set(G_OBJECT(Source), "typefind", TRUE, NULL);
+	g_object_set(G_OBJECT(Source), "touch", TRUE, NULL);
+	g_object_set(G_OBJECT(Source), "blocksize", config->tune.source_blocksize, NULL);
+	if(g_object_class_find_property(G_OBJECT_GET_CLASS(Demuxer), "window-size"))
+		g_object_set(G_OBJECT(Demuxer), "window-size", config->tune.demuxer_window, NULL);
+
+	gst_bin_add_many(GST_BIN(PipeLine), Source, Demuxer, NULL);
+	gst_element_link(Source, Demuxer);
+
+	if(VideoBin)
+		gst_bin_add(GST_BIN(PipeLine), VideoBin);
+
+	/* the audio bin is only built once the demuxer tells what it carries */
+	g_signal_connect(Demuxer, "pad-added", G_CALLBACK(on_pad_added), player);
+
+	return PipeLine;
+}
+
+static void freePipeLine(GstElement * PipeLine)
+{
+	if(PipeLine) {
+		gst_object_unref(GST_OBJECT(PipeLine));
+		PipeLine = NULL;
+	}
+}
+
+
+/*
+ * instance thread and API
+ */
+
+typedef gboolean (*xPlayerCallFunc)(xPlayer * player, gpointer data);
+
+typedef struct {
+	xPlayer * player;
+	xPlayerCallFunc func;
+	gpointer data;
+	gboolean result;
+	gboolean done;
+} xPlayerCall;
+
+static gboolean call_dispatch(gpointer data)
+{
+	xPlayerCall * call = (xPlayerCall *) data;
+	gboolean result = call->func(call->player, call->data);
+
+	g_mutex_lock(call->player->lock);
+	call->result = result;
+	call->done = TRUE;
+	g_cond_broadcast(call->player->cond);
+	g_mutex_unlock(call->player->lock);
+
+	return FALSE;
+}
+
+/* run func in the instance thread and wait for its result */
+static gboolean player_call(xPlayer * player, xPlayerCallFunc func, gpointer data)
+{
+	xPlayerCall call;
+	GSource * source;
+
+	/* already there, e.g. called from an event callback */
+	if(g_main_context_is_owner(player->context))
+		return func(player, data);
+
+	call.player = player;
+	call.func = func;
+	call.data = data;
+	call.result = FALSE;
+	call.done = FALSE;
+
+	source = g_idle_source_new();
+	g_source_set_callback(source, call_dispatch, &call, NULL);
+	g_source_attach(source, player->context);
+	g_source_unref(source);
+
+	g_mutex_lock(player->lock);
+	while(!call.done)
+		g_cond_wait(player->cond, player->lock);
+	g_mutex_unlock(player->lock);
+
+	return call.result;
+}
+
+static gpointer player_thread(gpointer data)
+{
+	xPlayer * player = (xPlayer *) data;
+
+	g_main_loop_run(player->loop);
+
+	return NULL;
+}
+
+static void stopPipeLine(GstElement * PipeLine)
+{
+	GstState state, pending;
+
+	gst_element_set_state(PipeLine, GST_STATE_READY);
+	gst_element_get_state(PipeLine, &state, &pending, GST_CLOCK_TIME_NONE);
+#ifndef MACH_IMX27
+	gst_element_set_state(PipeLine, GST_STATE_NULL);
+	gst_element_get_state(PipeLine, &state, &pending, GST_CLOCK_TIME_NONE);
+#endif
+}
+
+/* hook the per pipeline modules and the bus up to player->PipeLine */
+static void attach_pipeline(xPlayer * player)
+{
+	GstBus * bus;
+
+	mem_budget_apply(&player->budget, player->PipeLine, player->context);
+	xpos_init(&player->position, player->PipeLine);
+	xrec_init(&player->recovery, player->PipeLine, &player->position, player->context);
+	if(player->config.qos)
+		xqos_init(&player->qos, player->PipeLine,
+				player->config.tune.max_lateness >= 0 ? (GstClockTime) player->config.tune.max_lateness : XQOS_MAX_LATENESS);
+
+	if(player->config.track_alloc)
+		xtrack_attach(&player->track, player->PipeLine);
+
+	bus = gst_pipeline_get_bus(GST_PIPELINE(player->PipeLine));
+	player->bus_source = gst_bus_create_watch(bus);
+	g_source_set_callback(player->bus_source, (GSourceFunc) bus_call, player, NULL);
+	g_source_attach(player->bus_source, player->context);
+	gst_object_unref(bus);
+
+	g_static_mutex_lock(&player->swap_lock);
+	player->attached = TRUE;
+	g_static_mutex_unlock(&player->swap_lock);
+}
+
+static void detach_pipeline(xPlayer * player)
+{
+	g_static_mutex_lock(&player->swap_lock);
+	player->attached = FALSE;
+	g_static_mutex_unlock(&player->swap_lock);
+
+	g_source_destroy(player->bus_source);
+	g_source_unref(player->bus_source);
+	player->bus_source = NULL;
+
+	if(player->config.track_alloc)
+		xtrack_detach(&player->track);
+	mem_budget_report(&player->budget);
+	mem_budget_release(&player->budget);
+	xrec_report(&player->recovery);
+	xrec_release(&player->recovery);
+	xqos_report(&player->qos);
+	xqos_release(&player->qos);
+	xpos_release(&player->position);
+}
+
+/* the frame cache is complete, let it take over from the decoder */
+static gboolean do_replay(gpointer data)
+{
+	xPlayer * player = (xPlayer *) data;
+	GstElement * Decode = player->PipeLine;
+	GstElement * Replay;
+
+	/* otherwise keep looping on the decoder, its modules stay as they are */
+	if(!Decode || !xloop_replay_prepare(&player->looping))
+		return FALSE;
+
+	detach_pipeline(player);
+	mem_budget_init(&player->budget, player->config.mem_budget);
+
+	Replay = xloop_replay(&player->looping);
+
+	stopPipeLine(Decode);
+	freePipeLine(Decode);
+
+	player->PipeLine = Replay;
+	attach_pipeline(player);
+	gst_element_set_state(Replay, player->play ? GST_STATE_PLAYING : GST_STATE_PAUSED);
+
+	return FALSE;
+}
+
+/* not from the bus callback, do_replay() destroys its source */
+static void schedule_replay(xPlayer * player)
+{
+	GSource * source = g_idle_source_new();
+
+	g_source_set_callback(source, do_replay, player, NULL);
+	g_source_attach(source, player->context);
+	g_source_unref(source);
+}
+
+static gboolean do_unload(xPlayer * player, gpointer data)
+{
+	if(!player->PipeLine)
+		return TRUE;
+
+	stopPipeLine(player->PipeLine);
+	detach_pipeline(player);
+	if(player->config.loop)
+		xloop_release(&player->looping);
+
+	freePipeLine(player->PipeLine);
+	player->PipeLine = NULL;
+	player->play = FALSE;
+
+	/* only now everything the pipeline held should be gone */
+	if(player->config.track_alloc) {
+		xtrack_report(&player->track);
+		xtrack_release(&player->track);
+	}
+
+	return TRUE;
+}
+
+static gboolean do_load(xPlayer * player, gpointer data)
+{
+	const gchar * filename = (const gchar *) data;
+
+	do_unload(player, NULL);
+
+	mem_budget_init(&player->budget, player->config.mem_budget);
+
+	player->PipeLine = initPipeLine(player, filename, std_mpeg4);
+	if(!player->PipeLine) {
+		g_printerr("Pipeline not created.\n");
+		return FALSE;
+	}
+
+	if(player->config.track_alloc)
+		xtrack_init(&player->track);
+	attach_pipeline(player);
+	if(player->config.loop)
+		xloop_init(&player->looping, player->PipeLine, player->config.loop_cache, &player->budget, &player->qos);
+
+	/* preroll, so that play starts right away */
+	if(gst_element_set_state(player->PipeLine, GST_STATE_PAUSED) == GST_STATE_CHANGE_FAILURE) {
+		do_unload(player, NULL);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean do_set_state(xPlayer * player, gpointer data)
+{
+	GstState state = (GstState) GPOINTER_TO_INT(data);
+
+	if(!player->PipeLine)
+		return FALSE;
+
+	player->play = (state == GST_STATE_PLAYING);
+
+	return gst_element_set_state(player->PipeLine, state) != GST_STATE_CHANGE_FAILURE;
+}
+
+static gboolean do_seek(xPlayer * player, gpointer data)
+{
+	GstClockTime * position = (GstClockTime *) data;
+
+	if(!player->PipeLine)
+		return FALSE;
+
+	if(player->config.loop)
+		return seek_to_time(player->PipeLine, xloop_seek_target(&player->looping, *position), !player->looping.replaying);
+
+	return seek_to_time(player->PipeLine, *position, FALSE);
+}
+
+static gpointer global_init(gpointer data)
+{
+	asisbg_plugin_register();
+	autoplug_get_factories();
+
+	return NULL;
+}
+
+void xplayer_global_init(void)
+{
+	static GOnce once = G_ONCE_INIT;
+
+	g_once(&once, global_init, NULL);
+}
+
+void xplayer_config_init(xPlayerConfig * config)
+{
+	config->mem_budget = MEM_BUDGET_DEFAULT;
+	config->demuxer = "xavidemux";
+	config->video_scale = FALSE;
+	config->audio = TRUE;
+	config->qos = TRUE;
+	config->loop = FALSE;
+	config->loop_cache = 0;
+	config->track_alloc = FALSE;
+	config->overlay_text = NULL;
+	config->overlay_logo = NULL;
+	config->audio_buffer_time = XAUDIO_BUFFER_TIME;
+	config->audio_latency_time = XAUDIO_LATENCY_TIME;
+	config->display_x = 0;
+	config->display_y = 0;
+	tune_defaults(&config->tune);
+	config->headless = FALSE;
+}
+
+xPlayer * xplayer_new(const xPlayerConfig * config, xPlayerEventFunc func, gpointer user_data)
+{
+	xPlayer * player;
+	GError * err = NULL;
+
+	xplayer_global_init();
+
+	player = g_new0(xPlayer, 1);
+	if(config)
+		player->config = *config;
+	else
+		xplayer_config_init(&player->config);
+	player->config.demuxer = g_strdup(player->config.demuxer);
+	player->config.overlay_text = g_strdup(player->config.overlay_text);
+	player->config.overlay_logo = g_strdup(player->config.overlay_logo);
+	player->func = func;
+	player->user_data = user_data;
+
+	player->context = g_main_context_new();
+	player->loop = g_main_loop_new(player->context, FALSE);
+	player->lock = g_mutex_new();
+	player->cond = g_cond_new();
+	/* outlive the pipelines, the streaming threads may still be in a probe on detach */
+	g_static_mutex_init(&player->position.lock);
+	g_static_mutex_init(&player->qos.lock);
+	g_static_mutex_init(&player->swap_lock);
+
+	player->thread = g_thread_create(player_thread, player, TRUE, &err);
+	if(!player->thread) {
+		g_printerr("Player thread not created: %s\n", err ? err->message : "unknown error");
+		g_clear_error(&err);
+		xplayer_destroy(player);
+		return NULL;
+	}
+
+	return player;
+}
+
+gboolean xplayer_load(xPlayer * player, const gchar * filename)
+{
+	return player_call(player, do_load, (gpointer) filename);
+}
+
+gboolean xplayer_play(xPlayer * player)
+{
+	return player_call(player, do_set_state, GINT_TO_POINTER(GST_STATE_PLAYING));
+}
+
+gboolean xplayer_pause(xPlayer * player)
+{
+	return player_call(player, do_set_state, GINT_TO_POINTER(GST_STATE_PAUSED));
+}
+
+gboolean xplayer_seek(xPlayer * player, GstClockTime position)
+{
+	return player_call(player, do_seek, &position);
+}
+
+/* in the calling thread, replay and unload only hold swap_lock while they swap the modules */
+gboolean xplayer_get_position(xPlayer * player, GstClockTime * position, GstClockTime * duration)
+{
+	gboolean ret = FALSE;
+
+	g_static_mutex_lock(&player->swap_lock);
+	if(player->attached && xpos_get(&player->position, position, duration)) {
+		if(player->config.loop)
+			xloop_position(&player->looping, position, duration);
+		ret = TRUE;
+	}
+	g_static_mutex_unlock(&player->swap_lock);
+
+	return ret;
+}
+
+gboolean xplayer_get_qos(xPlayer * player, xQosStats * stats)
+{
+	gboolean ret = FALSE;
+
+	g_static_mutex_lock(&player->swap_lock);
+	if(player->attached) {
+		xqos_get_stats(&player->qos, stats);
+		ret = TRUE;
+	}
+	g_static_mutex_unlock(&player->swap_lock);
+
+	return ret;
+}
+
+void xplayer_destroy(xPlayer * player)
+{
+	if(player->thread) {
+		player_call(player, do_unload, NULL);
+		g_main_loop_quit(player->loop);
+		g_thread_join(player->thread);
+	}
+
+	g_main_loop_unref(player->loop);
+	g_main_context_unref(player->context);
+	g_mutex_free(player->lock);
+	g_cond_free(player->cond);
+	g_static_mutex_free(&player->position.lock);
+	g_static_mutex_free(&player->qos.lock);
+	g_static_mutex_free(&player->swap_lock);
+	g_free((gchar *) player->config.demuxer);
+	g_free((gchar *) player->config.overlay_text);
+	g_free((gchar *) player->config.overlay_logo);
+	g_free(player);
+}
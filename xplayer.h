@@ -0,0 +1,66 @@
+/*
+ * xplayer.h - embeddable player instance
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#ifndef XPLAYER_H_
+#define XPLAYER_H_
+
+#include <gst/gst.h>
+#include <glib.h>
+
+#include "xqos.h"
+#include "tunables.h"
+
+typedef struct _xPlayer xPlayer;
+
+typedef enum {
+	XPLAYER_EVENT_PLAYING,
+	XPLAYER_EVENT_PAUSED,
+	XPLAYER_EVENT_EOS,
+	XPLAYER_EVENT_ERROR,		/* detail is the error message */
+	XPLAYER_EVENT_RECOVERED,	/* a transient error was recovered from */
+} xPlayerEvent;
+
+/* called from the instance thread */
+typedef void (*xPlayerEventFunc)(xPlayer * player, xPlayerEvent event, const gchar * detail, gpointer user_data);
+
+typedef struct {
+	guint mem_budget;			/* bytes */
+	const gchar * demuxer;
+	gboolean video_scale;		/* x86: scale to the display window in software */
+	gint display_x;
+	gint display_y;
+	xTunables tune;				/* sizes and sink settings, see tunables.c */
+	gboolean headless;			/* fakesink instead of the display, for the autotuner */
+	gboolean audio;
+	guint audio_buffer_time;	/* alsasink ring buffer, us */
+	guint audio_latency_time;	/* alsasink period, us */
+	gboolean qos;				/* drop frames before the decoder when behind */
+	gboolean loop;				/* loop the clip seamlessly instead of EOS */
+	guint loop_cache;			/* bytes of decoded frames to replay short clips from, 0 is off */
+	gboolean track_alloc;		/* count buffer allocations, report them and leaks on unload */
+	const gchar * overlay_text;	/* shown over the video, NULL for none */
+	const gchar * overlay_logo;	/* PAM file shown left of the text, NULL for none */
+} xPlayerConfig;
+
+/* registers the in-tree elements, done by xplayer_new() as well */
+void xplayer_global_init(void);
+void xplayer_config_init(xPlayerConfig * config);
+
+/* gst_init() must have been called, and g_thread_init() before it */
+xPlayer * xplayer_new(const xPlayerConfig * config, xPlayerEventFunc func, gpointer user_data);
+gboolean xplayer_load(xPlayer * player, const gchar * filename);
+gboolean xplayer_play(xPlayer * player);
+gboolean xplayer_pause(xPlayer * player);
+gboolean xplayer_seek(xPlayer * player, GstClockTime position);
+/* these two read in the calling thread without waiting for the instance thread, fine to poll at UI rates */
+gboolean xplayer_get_position(xPlayer * player, GstClockTime * position, GstClockTime * duration);
+/* frame counters and costs */
+gboolean xplayer_get_qos(xPlayer * player, xQosStats * stats);
+/* not from the event callback, it joins the instance thread */
+void xplayer_destroy(xPlayer * player);
+
+#endif /* XPLAYER_H_ */
@@ -0,0 +1,248 @@
+/*
+ * xposition.c - cheap playback position tracking
+ *
+ * Instead of sending position and duration queries through the whole
+ * pipeline, the duration is queried once and the position is derived from
+ * the pipeline clock, the base time and the last segment seen on a sink
+ * pad. Reading it is a clock read under an uncontended lock, so it can be
+ * polled from any thread at UI rates.
+ *
+ * A sink with sync=FALSE (the iMX27 default) shows frames as soon as they
+ * come, so there the clock says nothing about what is on screen. The
+ * position is the timestamp of the last buffer the sink got instead.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#include <gst/gst.h>
+#include <glib.h>
+
+#include "xposition.h"
+
+/* position in stream time for the given running time, lock held */
+static GstClockTime running_to_position(xPosition * pos, GstClockTime running)
+{
+	GstSegment * seg = &pos->segment;
+	GstClockTime position;
+
+	if(running < (GstClockTime) seg->accum)
+		running = seg->accum;
+
+	position = seg->start + (GstClockTime) ((running - seg->accum) * seg->abs_rate);
+	if(seg->stop != -1 && position > (GstClockTime) seg->stop)
+		position = seg->stop;
+
+	return position - seg->start + seg->time;
+}
+
+/* lock held */
+static GstClockTime current_position(xPosition * pos)
+{
+	GstClockTime now;
+
+	if(!pos->sync)
+		return GST_CLOCK_TIME_IS_VALID(pos->last) ? pos->last : pos->frozen;
+
+	if(!pos->playing || !pos->clock)
+		return pos->frozen;
+
+	now = gst_clock_get_time(pos->clock);
+	if(now < pos->base_time)
+		return pos->frozen;
+
+	return running_to_position(pos, now - pos->base_time);
+}
+
+static gboolean segment_probe(GstPad * pad, GstEvent * event, void * data)
+{
+	xPosition * pos = (xPosition *) data;
+
+	switch(GST_EVENT_TYPE(event)) {
+	case GST_EVENT_NEWSEGMENT:
+	{
+		gboolean update;
+		gdouble rate, arate;
+		GstFormat format;
+		gint64 start, stop, time;
+
+		gst_event_parse_new_segment_full(event, &update, &rate, &arate, &format, &start, &stop, &time);
+		if(format != GST_FORMAT_TIME)
+			break;
+
+		g_static_mutex_lock(&pos->lock);
+		gst_segment_set_newsegment_full(&pos->segment, update, rate, arate, format, start, stop, time);
+		if(!pos->playing)
+			pos->frozen = time;
+		g_static_mutex_unlock(&pos->lock);
+		break;
+	}
+	case GST_EVENT_FLUSH_STOP:
+		/* running time starts again from 0 */
+		g_static_mutex_lock(&pos->lock);
+		gst_segment_init(&pos->segment, GST_FORMAT_TIME);
+		pos->last = GST_CLOCK_TIME_NONE;
+		g_static_mutex_unlock(&pos->lock);
+		break;
+	default:
+		break;
+	}
+
+	return TRUE;
+}
+
+static gboolean buffer_probe(GstPad * pad, GstBuffer * buf, void * data)
+{
+	xPosition * pos = (xPosition *) data;
+	gint64 position;
+
+	if(!GST_BUFFER_TIMESTAMP_IS_VALID(buf))
+		return TRUE;
+
+	g_static_mutex_lock(&pos->lock);
+	position = gst_segment_to_stream_time(&pos->segment, GST_FORMAT_TIME, GST_BUFFER_TIMESTAMP(buf));
+	if(position >= 0)
+		pos->last = position;
+	g_static_mutex_unlock(&pos->lock);
+
+	return TRUE;
+}
+
+/* the lock may be held by a poll of the previous pipeline, it is not touched here */
+void xpos_init(xPosition * pos, GstElement * PipeLine)
+{
+	GstElement * sink;
+	GstPad * pad = NULL;
+	gboolean sync = TRUE;
+
+	sink = gst_bin_get_by_name(GST_BIN(PipeLine), "video_sink");
+	if(!sink)
+		sink = gst_bin_get_by_name(GST_BIN(PipeLine), "audio_sink");
+	if(sink) {
+		pad = gst_element_get_static_pad(sink, "sink");
+		g_object_get(G_OBJECT(sink), "sync", &sync, NULL);
+		gst_object_unref(GST_OBJECT(sink));
+	}
+
+	g_static_mutex_lock(&pos->lock);
+	gst_segment_init(&pos->segment, GST_FORMAT_TIME);
+	pos->PipeLine = PipeLine;
+	pos->pad = pad;
+	pos->probe_id = 0;
+	pos->buffer_probe_id = 0;
+	pos->sync = sync;
+	pos->clock = NULL;
+	pos->base_time = 0;
+	pos->duration = GST_CLOCK_TIME_NONE;
+	pos->frozen = 0;
+	pos->last = GST_CLOCK_TIME_NONE;
+	pos->playing = FALSE;
+	g_static_mutex_unlock(&pos->lock);
+
+	if(pad) {
+		pos->probe_id = gst_pad_add_event_probe(pad, G_CALLBACK(segment_probe), pos);
+		if(!sync)
+			pos->buffer_probe_id = gst_pad_add_buffer_probe(pad, G_CALLBACK(buffer_probe), pos);
+	}
+}
+
+static void update_duration(xPosition * pos)
+{
+	GstFormat fmt = GST_FORMAT_TIME;
+	gint64 len;
+
+	if(gst_element_query_duration(pos->PipeLine, &fmt, &len) && fmt == GST_FORMAT_TIME && len >= 0) {
+		g_static_mutex_lock(&pos->lock);
+		pos->duration = len;
+		g_static_mutex_unlock(&pos->lock);
+	}
+}
+
+static void update_base_time(xPosition * pos)
+{
+	GstClock * clock = gst_pipeline_get_clock(GST_PIPELINE(pos->PipeLine));
+
+	g_static_mutex_lock(&pos->lock);
+	if(pos->clock)
+		gst_object_unref(pos->clock);
+	pos->clock = clock;
+	pos->base_time = gst_element_get_base_time(pos->PipeLine);
+	g_static_mutex_unlock(&pos->lock);
+}
+
+void xpos_handle_message(xPosition * pos, GstMessage * msg)
+{
+	switch(GST_MESSAGE_TYPE(msg)) {
+	case GST_MESSAGE_STATE_CHANGED:
+	{
+		GstState old, new, pending;
+
+		if(GST_MESSAGE_SRC(msg) != GST_OBJECT_CAST(pos->PipeLine))
+			break;
+
+		gst_message_parse_state_changed(msg, &old, &new, &pending);
+		if(new == GST_STATE_PLAYING) {
+			update_base_time(pos);
+			g_static_mutex_lock(&pos->lock);
+			pos->playing = TRUE;
+			g_static_mutex_unlock(&pos->lock);
+		}
+		else if(old == GST_STATE_PLAYING) {
+			g_static_mutex_lock(&pos->lock);
+			pos->frozen = current_position(pos);
+			pos->playing = FALSE;
+			g_static_mutex_unlock(&pos->lock);
+		}
+		break;
+	}
+	case GST_MESSAGE_ASYNC_DONE:
+		/* after a flushing seek the base time is redistributed */
+		if(!GST_CLOCK_TIME_IS_VALID(pos->duration))
+			update_duration(pos);
+		if(pos->playing)
+			update_base_time(pos);
+		break;
+	case GST_MESSAGE_DURATION:
+		update_duration(pos);
+		break;
+	case GST_MESSAGE_NEW_CLOCK:
+		if(pos->playing)
+			update_base_time(pos);
+		break;
+	default:
+		break;
+	}
+}
+
+gboolean xpos_get(xPosition * pos, GstClockTime * position, GstClockTime * duration)
+{
+	g_static_mutex_lock(&pos->lock);
+	*position = current_position(pos);
+	*duration = pos->duration;
+	g_static_mutex_unlock(&pos->lock);
+
+	return GST_CLOCK_TIME_IS_VALID(*duration);
+}
+
+/* the probes may still be running, the lock stays */
+void xpos_release(xPosition * pos)
+{
+	GstClock * clock;
+
+	if(pos->pad) {
+		gst_pad_remove_event_probe(pos->pad, pos->probe_id);
+		if(pos->buffer_probe_id)
+			gst_pad_remove_buffer_probe(pos->pad, pos->buffer_probe_id);
+		gst_object_unref(GST_OBJECT(pos->pad));
+		pos->pad = NULL;
+	}
+
+	g_static_mutex_lock(&pos->lock);
+	clock = pos->clock;
+	pos->clock = NULL;
+	pos->playing = FALSE;
+	g_static_mutex_unlock(&pos->lock);
+
+	if(clock)
+		gst_object_unref(clock);
+}
@@ -0,0 +1,36 @@
+/*
+ * xposition.h - cheap playback position tracking
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#ifndef XPOSITION_H_
+#define XPOSITION_H_
+
+#include <gst/gst.h>
+#include <glib.h>
+
+typedef struct {
+	GstElement * PipeLine;
+	GstPad * pad;			/* sink pad the segment is read from */
+	gulong probe_id;
+	gulong buffer_probe_id;	/* sinks not syncing to the clock only */
+
+	GStaticMutex lock;		/* set up by the owner, kept across init and release */
+	GstSegment segment;
+	gboolean sync;
+	GstClock * clock;
+	GstClockTime base_time;
+	GstClockTime duration;
+	GstClockTime frozen;	/* position while not playing */
+	GstClockTime last;		/* stream time of the last buffer the sink got */
+	gboolean playing;
+} xPosition;
+
+void xpos_init(xPosition * pos, GstElement * PipeLine);
+void xpos_handle_message(xPosition * pos, GstMessage * msg);
+gboolean xpos_get(xPosition * pos, GstClockTime * position, GstClockTime * duration);
+void xpos_release(xPosition * pos);
+
+#endif /* XPOSITION_H_ */
@@ -0,0 +1,534 @@
+/*
+ * xqos.c - CPU overload aware frame dropping
+ *
+ * Probes around the video decoder measure what every frame costs to decode
+ * and to get through the converter and the sink. Together with the pipeline
+ * clock that predicts how late a frame entering the decoder will be shown.
+ * When it would be late, frames nothing else refers to (MPEG-4 B-VOPs,
+ * H.264 pictures with nal_ref_idc 0) are dropped before they are decoded,
+ * which costs no picture quality on the following frames. Only an overload
+ * lasting longer than XQOS_SUSTAIN falls back to decoding keyframes only.
+ * Going back needs XQOS_RECOVER of being on time, and that window doubles
+ * every time the keyframe mode had to be entered again, so a marginal CPU
+ * settles instead of flapping between the modes.
+ *
+ * The clock is read in the probes, so this works with sync=FALSE sinks as
+ * well, where the sink itself never drops anything.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <gst/gst.h>
+#include <glib.h>
+
+#include "xqos.h"
+
+#define XQOS_SUSTAIN		(2 * GST_SECOND)
+#define XQOS_RECOVER		(1 * GST_SECOND)
+#define XQOS_RECOVER_MAX	(8 * GST_SECOND)
+#define XQOS_FRAME_DURATION	(40 * GST_MSECOND)	/* until the stream tells */
+
+static const gchar * level_name[] = {
+	[XQOS_LEVEL_NORMAL]		= "normal",
+	[XQOS_LEVEL_SKIP]		= "skip non-reference",
+	[XQOS_LEVEL_KEYFRAMES]	= "keyframes only",
+};
+
+/* running average over about 8 frames */
+static inline void cost_update(GstClockTime * avg, GstClockTime sample)
+{
+	*avg = *avg - *avg / 8 + sample / 8;
+}
+
+/* first 00 00 01 at or after p, with at least one byte after it */
+static const guint8 * next_start_code(const guint8 * p, const guint8 * end)
+{
+	while(p + 3 < end) {
+		if(p[2] > 1)
+			p += 3;
+		else if(p[2] == 0)
+			p++;
+		else if(p[0] == 0 && p[1] == 0)
+			return p;
+		else
+			p += 3;
+	}
+
+	return NULL;
+}
+
+/* all VOPs are B-VOPs, packed bitstream chunks may carry a P-VOP as well */
+static gboolean mpeg4_nonref(const guint8 * data, guint size)
+{
+	const guint8 * p = data, * end = data + size;
+	gboolean found = FALSE;
+
+	while((p = next_start_code(p, end)) && p + 4 < end) {
+		if(p[3] == 0xb6) {
+			if((p[4] >> 6) != 2)
+				return FALSE;
+			found = TRUE;
+		}
+		p += 4;
+	}
+
+	return found;
+}
+
+/* all slices of a picture share nal_ref_idc, so the first one decides */
+static gboolean h264_nonref(const guint8 * data, guint size, guint nal_length)
+{
+	const guint8 * p = data, * end = data + size;
+	guint type;
+
+	if(nal_length) {
+		while(p + nal_length < end) {
+			guint len = 0, i;
+
+			for(i = 0; i < nal_length; i++)
+				len = (len << 8) | p[i];
+			p += nal_length;
+
+			type = p[0] & 0x1f;
+			if(type >= 1 && type <= 5)
+				return (p[0] & 0x60) == 0;
+			if(len > (guint) (end - p))
+				break;
+			p += len;
+		}
+		return FALSE;
+	}
+
+	while((p = next_start_code(p, end))) {
+		type = p[3] & 0x1f;
+		if(type >= 1 && type <= 5)
+			return (p[3] & 0x60) == 0;
+		p += 3;
+	}
+
+	return FALSE;
+}
+
+/* lock held */
+static void set_codec(xQos * qos, GstCaps * caps)
+{
+	GstStructure * s;
+	const gchar * name;
+	const GValue * value;
+	gint version;
+
+	gst_caps_replace(&qos->caps, caps);
+	qos->codec = XQOS_CODEC_UNKNOWN;
+	qos->nal_length = 0;
+
+	if(!caps || gst_caps_is_empty(caps) || gst_caps_is_any(caps))
+		return;
+
+	s = gst_caps_get_structure(caps, 0);
+	name = gst_structure_get_name(s);
+
+	if(!strcmp(name, "video/mpeg")) {
+		if(gst_structure_get_int(s, "mpegversion", &version) && version == 4)
+			qos->codec = XQOS_CODEC_MPEG4;
+	}
+	else if(!strcmp(name, "video/x-divx")) {
+		/* DivX 3 is MS MPEG-4, no VOP start codes */
+		if(gst_structure_get_int(s, "divxversion", &version) && version >= 4)
+			qos->codec = XQOS_CODEC_MPEG4;
+	}
+	else if(!strcmp(name, "video/x-xvid")) {
+		qos->codec = XQOS_CODEC_MPEG4;
+	}
+	else if(!strcmp(name, "video/x-h264")) {
+		qos->codec = XQOS_CODEC_H264;
+		value = gst_structure_get_value(s, "codec_data");
+		if(value) {
+			GstBuffer * avcc = gst_value_get_buffer(value);
+
+			if(avcc && GST_BUFFER_SIZE(avcc) >= 5 && GST_BUFFER_DATA(avcc)[0] == 1)
+				qos->nal_length = (GST_BUFFER_DATA(avcc)[4] & 3) + 1;
+		}
+	}
+}
+
+static gboolean is_nonref(xQos * qos, GstBuffer * buf)
+{
+	switch(qos->codec) {
+	case XQOS_CODEC_MPEG4:
+		return mpeg4_nonref(GST_BUFFER_DATA(buf), GST_BUFFER_SIZE(buf));
+	case XQOS_CODEC_H264:
+		return h264_nonref(GST_BUFFER_DATA(buf), GST_BUFFER_SIZE(buf), qos->nal_length);
+	default:
+		return FALSE;
+	}
+}
+
+/* how late a frame with timestamp ts is right now, lock held */
+static gboolean lateness(xQos * qos, GstClockTime ts, gint64 * late)
+{
+	GstClock * clock;
+	GstClockTime running, now;
+
+	/* released while this probe was waiting for the lock */
+	if(!qos->VideoDec)
+		return FALSE;
+
+	/* the base time is only meaningful while playing */
+	if(GST_STATE(qos->VideoDec) != GST_STATE_PLAYING || !GST_CLOCK_TIME_IS_VALID(ts))
+		return FALSE;
+
+	running = gst_segment_to_running_time(&qos->segment, GST_FORMAT_TIME, ts);
+	if(!GST_CLOCK_TIME_IS_VALID(running))
+		return FALSE;
+
+	clock = gst_element_get_clock(qos->VideoDec);
+	if(!clock)
+		return FALSE;
+	now = gst_clock_get_time(clock);
+	gst_object_unref(clock);
+
+	*late = (gint64) (now - gst_element_get_base_time(qos->VideoDec)) - (gint64) running;
+
+	return TRUE;
+}
+
+/* lock held */
+static void set_level(xQos * qos, xQosLevel level, GstClockTime now)
+{
+	g_print("QoS: %s -> %s\n", level_name[qos->stats.level], level_name[level]);
+	qos->stats.level = level;
+	qos->ok_since = GST_CLOCK_TIME_IS_VALID(qos->ok_since) ? now : GST_CLOCK_TIME_NONE;
+}
+
+/* lock held, late is the predicted lateness at the sink */
+static void update_level(xQos * qos, GstClockTime now, gint64 late)
+{
+	if(late > (gint64) qos->max_lateness) {
+		if(!GST_CLOCK_TIME_IS_VALID(qos->overload_since))
+			qos->overload_since = now;
+		qos->ok_since = GST_CLOCK_TIME_NONE;
+	}
+	else if(late <= 0) {
+		if(!GST_CLOCK_TIME_IS_VALID(qos->ok_since))
+			qos->ok_since = now;
+		qos->overload_since = GST_CLOCK_TIME_NONE;
+	}
+
+	switch(qos->stats.level) {
+	case XQOS_LEVEL_NORMAL:
+		if(GST_CLOCK_TIME_IS_VALID(qos->overload_since))
+			set_level(qos, XQOS_LEVEL_SKIP, now);
+		break;
+	case XQOS_LEVEL_SKIP:
+		if(GST_CLOCK_TIME_IS_VALID(qos->overload_since) && now - qos->overload_since > XQOS_SUSTAIN) {
+			set_level(qos, XQOS_LEVEL_KEYFRAMES, now);
+		}
+		else if(GST_CLOCK_TIME_IS_VALID(qos->ok_since) && now - qos->ok_since > XQOS_RECOVER) {
+			set_level(qos, XQOS_LEVEL_NORMAL, now);
+			qos->recover_time = XQOS_RECOVER;
+		}
+		break;
+	case XQOS_LEVEL_KEYFRAMES:
+		/* being on time proves little here, the cost has to fit the frame rate too */
+		if(GST_CLOCK_TIME_IS_VALID(qos->ok_since) && now - qos->ok_since > qos->recover_time &&
+				qos->stats.decode_avg + qos->stats.render_avg < qos->frame_duration) {
+			set_level(qos, XQOS_LEVEL_SKIP, now);
+			qos->need_keyframe = TRUE;
+			qos->recover_time = MIN(qos->recover_time * 2, XQOS_RECOVER_MAX);
+		}
+		break;
+	}
+}
+
+/* lock held */
+static gboolean should_drop(xQos * qos, GstBuffer * buf, gboolean behind)
+{
+	gboolean delta = GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_DELTA_UNIT);
+
+	if(qos->suspended)
+		return FALSE;
+
+	/* references were dropped, only a keyframe can be decoded now */
+	if(qos->need_keyframe) {
+		if(delta)
+			return TRUE;
+		qos->need_keyframe = FALSE;
+	}
+
+	switch(qos->stats.level) {
+	case XQOS_LEVEL_SKIP:
+		return behind && is_nonref(qos, buf);
+	case XQOS_LEVEL_KEYFRAMES:
+		return delta;
+	default:
+		return FALSE;
+	}
+}
+
+static gboolean dec_event_probe(GstPad * pad, GstEvent * event, void * data)
+{
+	xQos * qos = (xQos *) data;
+
+	switch(GST_EVENT_TYPE(event)) {
+	case GST_EVENT_NEWSEGMENT:
+	{
+		gboolean update;
+		gdouble rate, arate;
+		GstFormat format;
+		gint64 start, stop, time;
+
+		gst_event_parse_new_segment_full(event, &update, &rate, &arate, &format, &start, &stop, &time);
+		if(format != GST_FORMAT_TIME)
+			break;
+
+		g_static_mutex_lock(&qos->lock);
+		gst_segment_set_newsegment_full(&qos->segment, update, rate, arate, format, start, stop, time);
+		g_static_mutex_unlock(&qos->lock);
+		break;
+	}
+	case GST_EVENT_FLUSH_STOP:
+		/* a seek makes everything late for a moment, that is no overload */
+		g_static_mutex_lock(&qos->lock);
+		gst_segment_init(&qos->segment, GST_FORMAT_TIME);
+		qos->overload_since = GST_CLOCK_TIME_NONE;
+		qos->ok_since = GST_CLOCK_TIME_NONE;
+		qos->dec_start = GST_CLOCK_TIME_NONE;
+		qos->dec_end = GST_CLOCK_TIME_NONE;
+		g_static_mutex_unlock(&qos->lock);
+		break;
+	default:
+		break;
+	}
+
+	return TRUE;
+}
+
+static gboolean dec_sink_probe(GstPad * pad, GstBuffer * buf, void * data)
+{
+	xQos * qos = (xQos *) data;
+	GstClockTime now = gst_util_get_timestamp();
+	gboolean behind = FALSE, drop;
+	gint64 late;
+
+	g_static_mutex_lock(&qos->lock);
+
+	if(!qos->VideoDec) {
+		g_static_mutex_unlock(&qos->lock);
+		return TRUE;
+	}
+
+	/*
+	 * The previous output went through the converter and the sink in this
+	 * thread before we got here again. Time the sink spent waiting for the
+	 * clock is not a cost.
+	 */
+	if(GST_CLOCK_TIME_IS_VALID(qos->dec_end)) {
+		gint64 render = (gint64) (now - qos->dec_end) - MAX(qos->sink_early, 0);
+
+		cost_update(&qos->stats.render_avg, MAX(render, 0));
+		qos->dec_end = GST_CLOCK_TIME_NONE;
+	}
+
+	if(GST_BUFFER_CAPS(buf) != qos->caps)
+		set_codec(qos, GST_BUFFER_CAPS(buf));
+	if(GST_BUFFER_DURATION_IS_VALID(buf) && GST_BUFFER_DURATION(buf))
+		qos->frame_duration = GST_BUFFER_DURATION(buf);
+	qos->stats.frames++;
+
+	if(lateness(qos, GST_BUFFER_TIMESTAMP(buf), &late)) {
+		late += qos->stats.decode_avg + qos->stats.render_avg;
+		update_level(qos, now, late);
+		behind = late > 0;
+	}
+
+	drop = should_drop(qos, buf, behind);
+	if(drop)
+		qos->stats.dropped++;
+	else
+		qos->dec_start = now;
+
+	g_static_mutex_unlock(&qos->lock);
+
+	return !drop;
+}
+
+static gboolean dec_src_probe(GstPad * pad, GstBuffer * buf, void * data)
+{
+	xQos * qos = (xQos *) data;
+	GstClockTime now = gst_util_get_timestamp();
+
+	g_static_mutex_lock(&qos->lock);
+	if(GST_CLOCK_TIME_IS_VALID(qos->dec_start)) {
+		cost_update(&qos->stats.decode_avg, now - qos->dec_start);
+		qos->dec_start = GST_CLOCK_TIME_NONE;
+	}
+	qos->dec_end = now;
+	g_static_mutex_unlock(&qos->lock);
+
+	return TRUE;
+}
+
+static gboolean sink_probe(GstPad * pad, GstBuffer * buf, void * data)
+{
+	xQos * qos = (xQos *) data;
+	gint64 late;
+
+	g_static_mutex_lock(&qos->lock);
+	qos->sink_early = 0;
+	if(lateness(qos, GST_BUFFER_TIMESTAMP(buf), &late)) {
+		if(late > (gint64) qos->max_lateness)
+			qos->stats.late++;
+		if(qos->sink_sync)
+			qos->sink_early = -late;
+	}
+	g_static_mutex_unlock(&qos->lock);
+
+	return TRUE;
+}
+
+/* everything but the lock, which the owner keeps across init and release; lock held */
+static void reset(xQos * qos)
+{
+	qos->VideoDec = NULL;
+	qos->dec_sink = NULL;
+	qos->dec_src = NULL;
+	qos->sink = NULL;
+	qos->dec_event_probe = 0;
+	qos->dec_sink_probe = 0;
+	qos->dec_src_probe = 0;
+	qos->sink_probe = 0;
+	qos->sink_sync = FALSE;
+
+	gst_segment_init(&qos->segment, GST_FORMAT_TIME);
+	gst_caps_replace(&qos->caps, NULL);
+	qos->codec = XQOS_CODEC_UNKNOWN;
+	qos->nal_length = 0;
+
+	qos->max_lateness = XQOS_MAX_LATENESS;
+	qos->frame_duration = XQOS_FRAME_DURATION;
+	qos->dec_start = GST_CLOCK_TIME_NONE;
+	qos->dec_end = GST_CLOCK_TIME_NONE;
+	qos->sink_early = 0;
+
+	qos->overload_since = GST_CLOCK_TIME_NONE;
+	qos->ok_since = GST_CLOCK_TIME_NONE;
+	qos->recover_time = XQOS_RECOVER;
+	qos->need_keyframe = FALSE;
+	qos->suspended = FALSE;
+
+	memset(&qos->stats, 0, sizeof(xQosStats));
+}
+
+void xqos_init(xQos * qos, GstElement * PipeLine, GstClockTime max_lateness)
+{
+	GstElement * VideoDec;
+	GstElement * VideoSink;
+	gboolean sync = FALSE;
+
+	VideoDec = gst_bin_get_by_name(GST_BIN(PipeLine), "video_decoder");
+	VideoSink = gst_bin_get_by_name(GST_BIN(PipeLine), "video_sink");
+	if(!(VideoDec && VideoSink)) {
+		if(VideoDec)
+			gst_object_unref(GST_OBJECT(VideoDec));
+		if(VideoSink)
+			gst_object_unref(GST_OBJECT(VideoSink));
+		return;
+	}
+
+	g_object_get(G_OBJECT(VideoSink), "sync", &sync, NULL);
+
+	g_static_mutex_lock(&qos->lock);
+	reset(qos);
+	qos->max_lateness = max_lateness;
+	qos->sink_sync = sync;
+	qos->VideoDec = VideoDec;
+	qos->dec_sink = gst_element_get_static_pad(VideoDec, "sink");
+	qos->dec_src = gst_element_get_static_pad(VideoDec, "src");
+	qos->sink = gst_element_get_static_pad(VideoSink, "sink");
+	g_static_mutex_unlock(&qos->lock);
+	gst_object_unref(GST_OBJECT(VideoSink));
+
+	qos->dec_event_probe = gst_pad_add_event_probe(qos->dec_sink, G_CALLBACK(dec_event_probe), qos);
+	qos->dec_sink_probe = gst_pad_add_buffer_probe(qos->dec_sink, G_CALLBACK(dec_sink_probe), qos);
+	qos->dec_src_probe = gst_pad_add_buffer_probe(qos->dec_src, G_CALLBACK(dec_src_probe), qos);
+	qos->sink_probe = gst_pad_add_buffer_probe(qos->sink, G_CALLBACK(sink_probe), qos);
+}
+
+/* while suspended every frame is decoded, the costs are still measured */
+void xqos_suspend(xQos * qos, gboolean suspend)
+{
+	g_static_mutex_lock(&qos->lock);
+	qos->suspended = suspend;
+	/* what was dropped before does not matter, the caller starts at a keyframe */
+	qos->need_keyframe = FALSE;
+	g_static_mutex_unlock(&qos->lock);
+}
+
+/* FALSE and zeroed stats when not attached */
+static gboolean get_stats(xQos * qos, xQosStats * stats)
+{
+	gboolean attached;
+
+	g_static_mutex_lock(&qos->lock);
+	attached = qos->VideoDec != NULL;
+	if(attached) {
+		*stats = qos->stats;
+		stats->frame_duration = qos->frame_duration;
+	}
+	else {
+		memset(stats, 0, sizeof(xQosStats));
+	}
+	g_static_mutex_unlock(&qos->lock);
+
+	return attached;
+}
+
+void xqos_get_stats(xQos * qos, xQosStats * stats)
+{
+	get_stats(qos, stats);
+}
+
+void xqos_report(xQos * qos)
+{
+	xQosStats stats;
+
+	if(!get_stats(qos, &stats))
+		return;
+
+	g_print("QoS: %" G_GUINT64_FORMAT " frames, %" G_GUINT64_FORMAT " dropped, %" G_GUINT64_FORMAT " late, "
+			"decode %.1f ms, render %.1f ms, ended %s\n",
+			stats.frames, stats.dropped, stats.late,
+			(gdouble) stats.decode_avg / GST_MSECOND, (gdouble) stats.render_avg / GST_MSECOND,
+			level_name[stats.level]);
+}
+
+/* a probe may still be waiting for the lock, it finds VideoDec gone */
+void xqos_release(xQos * qos)
+{
+	GstElement * VideoDec;
+	GstPad * dec_sink, * dec_src, * sink;
+
+	if(!qos->VideoDec)
+		return;
+
+	gst_pad_remove_event_probe(qos->dec_sink, qos->dec_event_probe);
+	gst_pad_remove_buffer_probe(qos->dec_sink, qos->dec_sink_probe);
+	gst_pad_remove_buffer_probe(qos->dec_src, qos->dec_src_probe);
+	gst_pad_remove_buffer_probe(qos->sink, qos->sink_probe);
+
+	g_static_mutex_lock(&qos->lock);
+	VideoDec = qos->VideoDec;
+	dec_sink = qos->dec_sink;
+	dec_src = qos->dec_src;
+	sink = qos->sink;
+	reset(qos);
+	g_static_mutex_unlock(&qos->lock);
+
+	gst_object_unref(GST_OBJECT(dec_sink));
+	gst_object_unref(GST_OBJECT(dec_src));
+	gst_object_unref(GST_OBJECT(sink));
+	gst_object_unref(GST_OBJECT(VideoDec));
+}
@@ -0,0 +1,76 @@
+/*
+ * xqos.h - CPU overload aware frame dropping
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#ifndef XQOS_H_
+#define XQOS_H_
+
+#include <gst/gst.h>
+#include <glib.h>
+
+#define XQOS_MAX_LATENESS	(20 * GST_MSECOND)
+
+typedef enum {
+	XQOS_CODEC_UNKNOWN,
+	XQOS_CODEC_MPEG4,
+	XQOS_CODEC_H264,
+} xQosCodec;
+
+typedef enum {
+	XQOS_LEVEL_NORMAL,		/* decode everything */
+	XQOS_LEVEL_SKIP,		/* skip non-reference frames while behind */
+	XQOS_LEVEL_KEYFRAMES,	/* sustained overload, keyframes only */
+} xQosLevel;
+
+typedef struct {
+	guint64 frames;			/* into the decoder */
+	guint64 dropped;		/* skipped before the decoder */
+	guint64 late;			/* reached the sink later than max-lateness */
+	GstClockTime decode_avg;
+	GstClockTime render_avg;
+	GstClockTime frame_duration;
+	xQosLevel level;
+} xQosStats;
+
+typedef struct {
+	GstElement * VideoDec;
+	GstPad * dec_sink;
+	GstPad * dec_src;
+	GstPad * sink;
+	gulong dec_event_probe;
+	gulong dec_sink_probe;
+	gulong dec_src_probe;
+	gulong sink_probe;
+	gboolean sink_sync;
+
+	GStaticMutex lock;		/* set up by the owner, kept across init and release */
+	GstSegment segment;
+	GstCaps * caps;
+	xQosCodec codec;
+	guint nal_length;		/* H.264: 0 for byte stream, else avcC length size */
+
+	GstClockTime max_lateness;
+	GstClockTime frame_duration;
+	GstClockTime dec_start;
+	GstClockTime dec_end;
+	gint64 sink_early;		/* how long the sink waited on the last frame */
+
+	GstClockTime overload_since;
+	GstClockTime ok_since;
+	GstClockTime recover_time;
+	gboolean need_keyframe;
+	gboolean suspended;		/* measure only, e.g. while the loop cache is filled */
+
+	xQosStats stats;
+} xQos;
+
+void xqos_init(xQos * qos, GstElement * PipeLine, GstClockTime max_lateness);
+void xqos_suspend(xQos * qos, gboolean suspend);
+void xqos_get_stats(xQos * qos, xQosStats * stats);
+void xqos_report(xQos * qos);
+void xqos_release(xQos * qos);
+
+#endif /* XQOS_H_ */
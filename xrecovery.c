@@ -0,0 +1,310 @@
+/*
+ * xrecovery.c - in-place recovery from transient pipeline errors
+ *
+ * A decoder glitch, a corrupt chunk or a busy device should not end the
+ * playback. An error from the video or the audio bin is recovered by
+ * resetting only that bin and doing a flushing seek to the last good
+ * position, a little further on with every attempt so the same bad chunk is
+ * not hit again. The source and the demuxer cannot be reset on their own:
+ * filesrc would come back in push mode, which xavidemux does not do, and the
+ * demuxer forgets its index and pads. For those the whole pipeline goes
+ * through READY, and the seek is done once it has prerolled again.
+ *
+ * The recovery is over when the pipeline prerolls after the seek
+ * (ASYNC_DONE) and its duration is recorded. Too many attempts in a short
+ * time make the error fatal, and so does a recovery that has not prerolled
+ * when its timeout fires: the timeout posts a core error on the bus, which
+ * ends the playback like any other fatal error.
+ *
+ * Only decode, demux and I/O errors are recovered from. STREAM FAILED is
+ * what demuxers post for not-linked and not-negotiated flows, a seek does
+ * not fix those.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#include <string.h>
+#include <gst/gst.h>
+#include <glib.h>
+
+#include "xrecovery.h"
+
+#define XREC_MAX_ATTEMPTS	3
+#define XREC_WINDOW			10.0					/* s */
+#define XREC_TIMEOUT		2000					/* ms, give up on a branch reset that does not preroll */
+#define XREC_RESTART_TIMEOUT	5000				/* ms, the same for a pipeline restart, it reads the index again */
+#define XREC_STATE_TIMEOUT	(1 * GST_SECOND)		/* for going to READY */
+#define XREC_SKIP			(500 * GST_MSECOND)		/* per attempt */
+
+void xrec_init(xRecovery * rec, GstElement * PipeLine, xPosition * position, GMainContext * context)
+{
+	rec->PipeLine = PipeLine;
+	rec->position = position;
+	rec->context = context;
+	rec->timeout = NULL;
+	rec->timer = g_timer_new();
+	rec->pending = FALSE;
+	rec->restart = FALSE;
+	rec->target = GST_CLOCK_TIME_NONE;
+	rec->resume = GST_STATE_VOID_PENDING;
+	rec->window = g_timer_new();
+	rec->attempts = 0;
+	rec->recovered = 0;
+	rec->total_ms = 0;
+	rec->max_ms = 0;
+}
+
+xRecoveryClass xrec_classify(const GError * error)
+{
+	if(error->domain == GST_STREAM_ERROR) {
+		switch(error->code) {
+		case GST_STREAM_ERROR_DECODE:
+		case GST_STREAM_ERROR_DEMUX:
+			return XREC_TRANSIENT;
+		default:
+			return XREC_FATAL;
+		}
+	}
+
+	if(error->domain == GST_RESOURCE_ERROR) {
+		switch(error->code) {
+		case GST_RESOURCE_ERROR_BUSY:
+		case GST_RESOURCE_ERROR_READ:
+		case GST_RESOURCE_ERROR_WRITE:
+		case GST_RESOURCE_ERROR_SYNC:
+			return XREC_TRANSIENT;
+		default:
+			return XREC_FATAL;
+		}
+	}
+
+	/* core errors (negotiation, missing plugins, ...) and library errors */
+	return XREC_FATAL;
+}
+
+/* the direct child of the pipeline that contains the failing element */
+static GstElement * failing_child(xRecovery * rec, GstObject * src)
+{
+	GstObject * obj = gst_object_ref(src);
+
+	while(obj) {
+		GstObject * parent = gst_object_get_parent(obj);
+
+		if(!parent) {
+			gst_object_unref(obj);
+			return NULL;
+		}
+		if(parent == GST_OBJECT_CAST(rec->PipeLine)) {
+			gst_object_unref(parent);
+			if(GST_IS_ELEMENT(obj))
+				return GST_ELEMENT(obj);
+			gst_object_unref(obj);
+			return NULL;
+		}
+		gst_object_unref(obj);
+		obj = parent;
+	}
+
+	return NULL;
+}
+
+static gboolean seek_target(xRecovery * rec)
+{
+	if(!gst_element_seek(rec->PipeLine, 1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT,
+			GST_SEEK_TYPE_SET, rec->target, GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE)) {
+		g_print("Recovery: seek failed\n");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* the branches are bins of their own, anything else takes the pipeline down with it */
+static gboolean is_branch(GstElement * child)
+{
+	return !strcmp(GST_ELEMENT_NAME(child), "video_bin") || !strcmp(GST_ELEMENT_NAME(child), "audio_bin");
+}
+
+gboolean xrec_pending(xRecovery * rec)
+{
+	return rec->pending;
+}
+
+static void stop_timeout(xRecovery * rec)
+{
+	if(rec->timeout) {
+		g_source_destroy(rec->timeout);
+		g_source_unref(rec->timeout);
+		rec->timeout = NULL;
+	}
+}
+
+/* still not prerolled, hand the player a fatal error through the bus */
+static gboolean recovery_timeout(gpointer data)
+{
+	xRecovery * rec = (xRecovery *) data;
+	GError * error;
+
+	g_source_unref(rec->timeout);
+	rec->timeout = NULL;
+	if(!rec->pending)
+		return FALSE;
+
+	rec->pending = FALSE;
+	rec->restart = FALSE;
+	rec->resume = GST_STATE_VOID_PENDING;
+
+	error = g_error_new(GST_CORE_ERROR, GST_CORE_ERROR_FAILED, "Recovery did not complete in %.0f ms",
+			g_timer_elapsed(rec->timer, NULL) * 1000);
+	gst_element_post_message(rec->PipeLine, gst_message_new_error(GST_OBJECT(rec->PipeLine), error, NULL));
+	g_error_free(error);
+
+	return FALSE;
+}
+
+static void start_recovery(xRecovery * rec, guint timeout)
+{
+	stop_timeout(rec);
+	g_timer_start(rec->timer);
+	rec->pending = TRUE;
+
+	rec->timeout = g_timeout_source_new(timeout);
+	g_source_set_callback(rec->timeout, recovery_timeout, rec, NULL);
+	g_source_attach(rec->timeout, rec->context);
+}
+
+static void fail_recovery(xRecovery * rec)
+{
+	stop_timeout(rec);
+	rec->pending = FALSE;
+	rec->restart = FALSE;
+	rec->resume = GST_STATE_VOID_PENDING;
+}
+
+gboolean xrec_handle_error(xRecovery * rec, GstMessage * msg, const GError * error)
+{
+	GstElement * child;
+	GstClockTime pos, len, target;
+	GstStateChangeReturn ret;
+
+	/* errors come in bursts, e.g. the decoder and then the demuxer, the timeout covers the rest */
+	if(rec->pending)
+		return TRUE;
+
+	if(xrec_classify(error) != XREC_TRANSIENT)
+		return FALSE;
+
+	if(g_timer_elapsed(rec->window, NULL) > XREC_WINDOW) {
+		g_timer_start(rec->window);
+		rec->attempts = 0;
+	}
+	if(rec->attempts >= XREC_MAX_ATTEMPTS) {
+		g_print("Recovery: %u attempts in %.0f s, giving up\n", rec->attempts, XREC_WINDOW);
+		return FALSE;
+	}
+	rec->attempts++;
+
+	child = failing_child(rec, GST_MESSAGE_SRC(msg));
+	if(!child)
+		return FALSE;
+
+	xpos_get(rec->position, &pos, &len);
+	target = pos + (rec->attempts - 1) * XREC_SKIP;
+	if(GST_CLOCK_TIME_IS_VALID(len) && target >= len) {
+		gst_object_unref(GST_OBJECT(child));
+		return FALSE;
+	}
+
+	rec->target = target;
+
+	if(is_branch(child)) {
+		g_print("Recovery: resetting %s, resuming at %" GST_TIME_FORMAT "\n", GST_ELEMENT_NAME(child), GST_TIME_ARGS(target));
+
+		start_recovery(rec, XREC_TIMEOUT);
+		rec->restart = FALSE;
+		rec->resume = GST_STATE_VOID_PENDING;
+		gst_element_set_state(child, GST_STATE_READY);
+		gst_element_sync_state_with_parent(child);
+		gst_object_unref(GST_OBJECT(child));
+
+		if(!seek_target(rec)) {
+			fail_recovery(rec);
+			return FALSE;
+		}
+		return TRUE;
+	}
+
+	g_print("Recovery: %s failed, restarting the pipeline, resuming at %" GST_TIME_FORMAT "\n",
+			GST_ELEMENT_NAME(child), GST_TIME_ARGS(target));
+	gst_object_unref(GST_OBJECT(child));
+
+	/* prerolled in PAUSED first, the demuxer has to read its index before it can seek */
+	start_recovery(rec, XREC_RESTART_TIMEOUT);
+	rec->restart = TRUE;
+	rec->resume = GST_STATE_TARGET(rec->PipeLine);
+	ret = gst_element_set_state(rec->PipeLine, GST_STATE_READY);
+	/* going down is not async, an element that makes it so gets a bounded wait */
+	if(ret == GST_STATE_CHANGE_ASYNC)
+		ret = gst_element_get_state(rec->PipeLine, NULL, NULL, XREC_STATE_TIMEOUT);
+	if(ret == GST_STATE_CHANGE_SUCCESS || ret == GST_STATE_CHANGE_NO_PREROLL)
+		ret = gst_element_set_state(rec->PipeLine, GST_STATE_PAUSED);
+	else
+		ret = GST_STATE_CHANGE_FAILURE;
+	if(ret == GST_STATE_CHANGE_FAILURE) {
+		g_print("Recovery: restart failed\n");
+		fail_recovery(rec);
+		return FALSE;
+	}
+
+	/* the preroll completes in ASYNC_DONE */
+	return TRUE;
+}
+
+/* returns TRUE when msg completes a recovery */
+gboolean xrec_handle_message(xRecovery * rec, GstMessage * msg)
+{
+	gdouble ms;
+
+	if(!rec->pending || GST_MESSAGE_TYPE(msg) != GST_MESSAGE_ASYNC_DONE)
+		return FALSE;
+
+	/* prerolled after the restart, now seek, the next ASYNC_DONE completes it */
+	if(rec->restart) {
+		rec->restart = FALSE;
+		if(seek_target(rec))
+			return FALSE;
+	}
+
+	stop_timeout(rec);
+	ms = g_timer_elapsed(rec->timer, NULL) * 1000;
+	rec->pending = FALSE;
+	rec->recovered++;
+	rec->total_ms += ms;
+	if(ms > rec->max_ms)
+		rec->max_ms = ms;
+
+	if(rec->resume == GST_STATE_PLAYING)
+		gst_element_set_state(rec->PipeLine, GST_STATE_PLAYING);
+	rec->resume = GST_STATE_VOID_PENDING;
+
+	g_print("Recovery: resumed in %.1f ms\n", ms);
+
+	return TRUE;
+}
+
+void xrec_report(xRecovery * rec)
+{
+	if(!rec->recovered)
+		return;
+
+	g_print("Recovery: %u recoveries, average %.1f ms, worst %.1f ms\n",
+			rec->recovered, rec->total_ms / rec->recovered, rec->max_ms);
+}
+
+void xrec_release(xRecovery * rec)
+{
+	stop_timeout(rec);
+	g_timer_destroy(rec->timer);
+	g_timer_destroy(rec->window);
+}
@@ -0,0 +1,48 @@
+/*
+ * xrecovery.h - in-place recovery from transient pipeline errors
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#ifndef XRECOVERY_H_
+#define XRECOVERY_H_
+
+#include <gst/gst.h>
+#include <glib.h>
+
+#include "xposition.h"
+
+typedef enum {
+	XREC_FATAL,
+	XREC_TRANSIENT,
+} xRecoveryClass;
+
+typedef struct {
+	GstElement * PipeLine;
+	xPosition * position;
+	GMainContext * context;	/* the one the bus watch runs on */
+	GSource * timeout;		/* fails a recovery that does not preroll */
+
+	GTimer * timer;			/* running while a recovery is in progress */
+	gboolean pending;
+	gboolean restart;		/* the pipeline went through READY, the seek waits for the preroll */
+	GstClockTime target;
+	GstState resume;		/* state to go back to once recovered */
+	GTimer * window;		/* attempts are counted per window */
+	guint attempts;
+
+	guint recovered;
+	gdouble total_ms;
+	gdouble max_ms;
+} xRecovery;
+
+void xrec_init(xRecovery * rec, GstElement * PipeLine, xPosition * position, GMainContext * context);
+xRecoveryClass xrec_classify(const GError * error);
+gboolean xrec_handle_error(xRecovery * rec, GstMessage * msg, const GError * error);
+gboolean xrec_handle_message(xRecovery * rec, GstMessage * msg);
+gboolean xrec_pending(xRecovery * rec);
+void xrec_report(xRecovery * rec);
+void xrec_release(xRecovery * rec);
+
+#endif /* XRECOVERY_H_ */
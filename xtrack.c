@@ -0,0 +1,419 @@
+/*
+ * xtrack.c - buffer allocation and object leak tracker
+ *
+ * Opt-in, for finding buffer churn and leaks. Every source pad of every
+ * element in the pipeline gets a buffer probe. A buffer the tracker has not
+ * seen yet was made by the element pushing it, a buffer it has seen was
+ * passed through, so the allocations are charged to the element that made
+ * them, per buffer size class. With mini object weak refs (0.10.35) the
+ * frees are counted too, otherwise only the process-wide live counts from
+ * GstAllocTrace are there, when the core was built with it.
+ *
+ * Elements and pads carry a GObject weak ref. Whatever is still alive once
+ * the pipeline is unreffed on unload is reported as leaked, together with
+ * its refcount.
+ *
+ * Allocations per frame shown is the figure to watch between versions.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#include <stdio.h>
+#include <gst/gst.h>
+#include <glib.h>
+
+#include "xtrack.h"
+
+/*
+ * Marks buffers the tracker has seen. Out of the range of the core and the
+ * media flags; setting it on a shared buffer is not strictly allowed, but the
+ * flag means nothing to anybody else.
+ */
+#define XTRACK_FLAG_SEEN	(GST_BUFFER_FLAG_LAST << 8)
+
+typedef struct {
+	xTrackElement * stats;		/* elements, and source pads for their parent */
+	gulong probe;				/* pads */
+	gulong pad_added;			/* elements */
+	gulong element_added;		/* bins */
+} xTrackObject;
+
+static const gchar * trace_name[] = { "GstBuffer", "GstEvent" };
+
+/* the 64 bit byte counters, atomics do the rest */
+static GStaticMutex bytes_lock = G_STATIC_MUTEX_INIT;
+
+static void track_element(xTrack * track, GstElement * element);
+
+static guint size_class(guint size)
+{
+	guint c = 0, limit = 256;
+
+	while(size > limit && c < XTRACK_CLASSES - 1) {
+		limit <<= 1;
+		c++;
+	}
+
+	return c;
+}
+
+static void element_unref(xTrackElement * stats)
+{
+	if(g_atomic_int_dec_and_test(&stats->ref)) {
+		g_free(stats->name);
+		g_free(stats);
+	}
+}
+
+static xTrackElement * element_new(const gchar * name)
+{
+	xTrackElement * stats = g_new0(xTrackElement, 1);
+	guint c;
+
+	stats->name = g_strdup(name);
+	stats->ref = 1;
+	for(c = 0; c < XTRACK_CLASSES; c++)
+		stats->cls[c].element = stats;
+
+	return stats;
+}
+
+#ifdef XTRACK_FREES
+static void buffer_freed(gpointer data, GstMiniObject * where_the_object_was)
+{
+	xTrackClass * cls = (xTrackClass *) data;
+
+	g_atomic_int_inc(&cls->frees);
+	g_atomic_int_inc(&cls->element->frees);
+	element_unref(cls->element);
+}
+#endif
+
+static gboolean src_buffer_probe(GstPad * pad, GstBuffer * buf, gpointer data)
+{
+	xTrackElement * stats = (xTrackElement *) data;
+	xTrackClass * cls;
+
+	if(GST_BUFFER_FLAG_IS_SET(buf, XTRACK_FLAG_SEEN))
+		return TRUE;
+	GST_BUFFER_FLAG_SET(buf, XTRACK_FLAG_SEEN);
+
+	cls = &stats->cls[size_class(GST_BUFFER_SIZE(buf))];
+	g_atomic_int_inc(&cls->allocs);
+	g_atomic_int_inc(&stats->allocs);
+
+	g_static_mutex_lock(&bytes_lock);
+	stats->bytes += GST_BUFFER_SIZE(buf);
+	g_static_mutex_unlock(&bytes_lock);
+
+#ifdef XTRACK_FREES
+	g_atomic_int_inc(&stats->ref);
+	gst_mini_object_weak_ref(GST_MINI_OBJECT(buf), buffer_freed, cls);
+#endif
+
+	return TRUE;
+}
+
+static gboolean frame_probe(GstPad * pad, GstBuffer * buf, gpointer data)
+{
+	xTrack * track = (xTrack *) data;
+
+	g_atomic_int_inc(&track->frames);
+
+	return TRUE;
+}
+
+static void object_gone(gpointer data, GObject * where_the_object_was)
+{
+	xTrack * track = (xTrack *) data;
+
+	g_static_rec_mutex_lock(&track->lock);
+	g_hash_table_remove(track->objects, where_the_object_was);
+	g_static_rec_mutex_unlock(&track->lock);
+}
+
+/* lock held */
+static xTrackObject * track_object(xTrack * track, GObject * object)
+{
+	xTrackObject * obj = g_hash_table_lookup(track->objects, object);
+
+	if(!obj) {
+		obj = g_new0(xTrackObject, 1);
+		g_hash_table_insert(track->objects, object, obj);
+		g_object_weak_ref(object, object_gone, track);
+	}
+
+	return obj;
+}
+
+/* lock held */
+static void track_pad(xTrack * track, GstPad * pad, xTrackElement * stats)
+{
+	xTrackObject * obj = track_object(track, G_OBJECT(pad));
+
+	if(!obj->probe)
+		obj->probe = gst_pad_add_buffer_probe(pad, G_CALLBACK(src_buffer_probe), stats);
+}
+
+/* streaming thread for the demuxer and decoder pads */
+static void on_pad_added(GstElement * element, GstPad * pad, gpointer data)
+{
+	xTrack * track = (xTrack *) data;
+	xTrackObject * obj;
+
+	if(GST_PAD_DIRECTION(pad) != GST_PAD_SRC)
+		return;
+
+	g_static_rec_mutex_lock(&track->lock);
+	obj = g_hash_table_lookup(track->objects, element);
+	if(obj)
+		track_pad(track, pad, obj->stats);
+	g_static_rec_mutex_unlock(&track->lock);
+}
+
+/* the audio branch and autoplugged decoders come in after attach */
+static void on_element_added(GstBin * bin, GstElement * element, gpointer data)
+{
+	xTrack * track = (xTrack *) data;
+
+	g_static_rec_mutex_lock(&track->lock);
+	track_element(track, element);
+	g_static_rec_mutex_unlock(&track->lock);
+}
+
+/* lock held */
+static void track_element(xTrack * track, GstElement * element)
+{
+	xTrackObject * obj = track_object(track, G_OBJECT(element));
+	GstIterator * it;
+	gpointer item;
+	gboolean done = FALSE;
+	gboolean bin = GST_IS_BIN(element);
+
+	if(!obj->stats) {
+		obj->stats = element_new(GST_OBJECT_NAME(element));
+		g_ptr_array_add(track->elements, obj->stats);
+	}
+
+	/* the ghost pads of a bin pass on what its children made */
+	if(bin) {
+		if(!obj->element_added)
+			obj->element_added = g_signal_connect(element, "element-added", G_CALLBACK(on_element_added), track);
+		it = gst_bin_iterate_elements(GST_BIN(element));
+	}
+	else {
+		if(!obj->pad_added)
+			obj->pad_added = g_signal_connect(element, "pad-added", G_CALLBACK(on_pad_added), track);
+		it = gst_element_iterate_src_pads(element);
+	}
+
+	while(!done) {
+		switch(gst_iterator_next(it, &item)) {
+		case GST_ITERATOR_OK:
+			if(bin)
+				track_element(track, GST_ELEMENT(item));
+			else
+				track_pad(track, GST_PAD(item), obj->stats);
+			gst_object_unref(item);
+			break;
+		case GST_ITERATOR_RESYNC:
+			gst_iterator_resync(it);
+			break;
+		default:
+			done = TRUE;
+			break;
+		}
+	}
+	gst_iterator_free(it);
+}
+
+void xtrack_init(xTrack * track)
+{
+	guint i;
+
+	g_static_rec_mutex_init(&track->lock);
+	track->objects = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+	track->elements = g_ptr_array_new();
+	track->frames = 0;
+
+	for(i = 0; i < G_N_ELEMENTS(trace_name); i++)
+		track->trace_base[i] = 0;
+#ifndef GST_DISABLE_TRACE
+	if(gst_alloc_trace_available()) {
+		gst_alloc_trace_set_flags_all(GST_ALLOC_TRACE_LIVE);
+		for(i = 0; i < G_N_ELEMENTS(trace_name); i++) {
+			GstAllocTrace * trace = gst_alloc_trace_get(trace_name[i]);
+
+			if(trace)
+				track->trace_base[i] = trace->live;
+		}
+	}
+#endif
+}
+
+void xtrack_attach(xTrack * track, GstElement * PipeLine)
+{
+	GstElement * VideoSink;
+	GstPad * pad;
+	xTrackObject * obj;
+
+	g_static_rec_mutex_lock(&track->lock);
+
+	track_element(track, PipeLine);
+
+	/* frames are what the sink got, from the decoder or the loop cache */
+	VideoSink = gst_bin_get_by_name(GST_BIN(PipeLine), "video_sink");
+	if(VideoSink) {
+		pad = gst_element_get_static_pad(VideoSink, "sink");
+		obj = track_object(track, G_OBJECT(pad));
+		if(!obj->probe)
+			obj->probe = gst_pad_add_buffer_probe(pad, G_CALLBACK(frame_probe), track);
+		gst_object_unref(pad);
+		gst_object_unref(VideoSink);
+	}
+
+	g_static_rec_mutex_unlock(&track->lock);
+}
+
+static void detach_object(gpointer key, gpointer value, gpointer data)
+{
+	xTrackObject * obj = (xTrackObject *) value;
+
+	if(obj->probe)
+		gst_pad_remove_buffer_probe(GST_PAD(key), obj->probe);
+	if(obj->pad_added)
+		g_signal_handler_disconnect(key, obj->pad_added);
+	if(obj->element_added)
+		g_signal_handler_disconnect(key, obj->element_added);
+	obj->probe = obj->pad_added = obj->element_added = 0;
+}
+
+/* the counters stay, xtrack_attach() goes on with another pipeline */
+void xtrack_detach(xTrack * track)
+{
+	g_static_rec_mutex_lock(&track->lock);
+	g_hash_table_foreach(track->objects, detach_object, NULL);
+	g_static_rec_mutex_unlock(&track->lock);
+}
+
+static void report_leak(gpointer key, gpointer value, gpointer data)
+{
+	guint * leaks = (guint *) data;
+	gchar * path = gst_object_get_path_string(GST_OBJECT(key));
+
+	g_print("Alloc tracker: LEAK %s %s, refcount %u\n", G_OBJECT_TYPE_NAME(key), path, G_OBJECT(key)->ref_count);
+	g_free(path);
+	(*leaks)++;
+}
+
+static void report_count(gint count)
+{
+#ifdef XTRACK_FREES
+	g_print(" %8d", count);
+#else
+	g_print(" %8s", "-");
+#endif
+}
+
+/* after the pipeline is gone, what is still tracked leaked */
+void xtrack_report(xTrack * track)
+{
+	guint64 bytes = 0;
+	gint frames = g_atomic_int_get(&track->frames);
+	gint allocs = 0, frees = 0, c_allocs, c_frees;
+	guint leaks = 0;
+	guint i, c;
+
+	g_static_rec_mutex_lock(&track->lock);
+
+	g_print("Alloc tracker: %d frames\n", frames);
+	g_print("%16s %8s %8s %8s %10s %9s\n", "element", "allocs", "frees", "live", "KB", "per frame");
+	for(i = 0; i < track->elements->len; i++) {
+		xTrackElement * stats = g_ptr_array_index(track->elements, i);
+		gint a = g_atomic_int_get(&stats->allocs), f = g_atomic_int_get(&stats->frees);
+
+		if(!a)
+			continue;
+		g_print("%16s %8d", stats->name, a);
+		report_count(f);
+		report_count(a - f);
+		g_static_mutex_lock(&bytes_lock);
+		g_print(" %10" G_GUINT64_FORMAT " %9.2f\n", stats->bytes / 1024, frames ? (gdouble) a / frames : 0);
+		bytes += stats->bytes;
+		g_static_mutex_unlock(&bytes_lock);
+		allocs += a;
+		frees += f;
+	}
+	g_print("%16s %8d", "total", allocs);
+	report_count(frees);
+	report_count(allocs - frees);
+	g_print(" %10" G_GUINT64_FORMAT " %9.2f\n", bytes / 1024, frames ? (gdouble) allocs / frames : 0);
+
+	g_print("%16s %8s %8s %8s\n", "size class", "allocs", "frees", "live");
+	for(c = 0; c < XTRACK_CLASSES; c++) {
+		gchar label[16];
+
+		c_allocs = c_frees = 0;
+		for(i = 0; i < track->elements->len; i++) {
+			xTrackElement * stats = g_ptr_array_index(track->elements, i);
+
+			c_allocs += g_atomic_int_get(&stats->cls[c].allocs);
+			c_frees += g_atomic_int_get(&stats->cls[c].frees);
+		}
+		if(!c_allocs)
+			continue;
+		if(c < XTRACK_CLASSES - 1)
+			g_snprintf(label, sizeof(label), "<= %u", 256 << c);
+		else
+			g_snprintf(label, sizeof(label), "> %u", 256 << (c - 1));
+		g_print("%16s %8d", label, c_allocs);
+		report_count(c_frees);
+		report_count(c_allocs - c_frees);
+		g_print("\n");
+	}
+
+#ifndef GST_DISABLE_TRACE
+	if(gst_alloc_trace_available()) {
+		for(i = 0; i < G_N_ELEMENTS(trace_name); i++) {
+			GstAllocTrace * trace = gst_alloc_trace_get(trace_name[i]);
+
+			if(trace)
+				g_print("Alloc tracker: %s live %+d since load\n", trace_name[i], trace->live - track->trace_base[i]);
+		}
+	}
+#endif
+
+	g_hash_table_foreach(track->objects, report_leak, &leaks);
+	g_print("Alloc tracker: %.2f allocations per frame, %u objects leaked\n",
+			frames ? (gdouble) allocs / frames : 0, leaks);
+
+	g_static_rec_mutex_unlock(&track->lock);
+}
+
+static gboolean release_object(gpointer key, gpointer value, gpointer data)
+{
+	detach_object(key, value, NULL);
+	g_object_weak_unref(G_OBJECT(key), object_gone, data);
+
+	return TRUE;
+}
+
+void xtrack_release(xTrack * track)
+{
+	guint i;
+
+	g_static_rec_mutex_lock(&track->lock);
+	g_hash_table_foreach_remove(track->objects, release_object, track);
+	g_hash_table_destroy(track->objects);
+	track->objects = NULL;
+
+	/* buffers still around keep their element counters */
+	for(i = 0; i < track->elements->len; i++)
+		element_unref(g_ptr_array_index(track->elements, i));
+	g_ptr_array_free(track->elements, TRUE);
+	track->elements = NULL;
+	g_static_rec_mutex_unlock(&track->lock);
+
+	g_static_rec_mutex_free(&track->lock);
+}
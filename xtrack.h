@@ -0,0 +1,53 @@
+/*
+ * xtrack.h - buffer allocation and object leak tracker
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: xpucmo
+ */
+
+#ifndef XTRACK_H_
+#define XTRACK_H_
+
+#include <gst/gst.h>
+#include <glib.h>
+
+#define XTRACK_CLASSES		14		/* <= 256 bytes up to <= 1 MB, then the rest */
+
+/* frees are only known with mini object weak refs */
+#if GST_CHECK_VERSION(0, 10, 35)
+#define XTRACK_FREES
+#endif
+
+struct _xTrackElement;
+
+typedef struct {
+	struct _xTrackElement * element;
+	volatile gint allocs;
+	volatile gint frees;
+} xTrackClass;
+
+/* counters of one element, kept after the element is gone */
+typedef struct _xTrackElement {
+	gchar * name;
+	volatile gint ref;			/* the tracker and every live buffer */
+	volatile gint allocs;
+	volatile gint frees;
+	guint64 bytes;
+	xTrackClass cls[XTRACK_CLASSES];
+} xTrackElement;
+
+typedef struct {
+	GStaticRecMutex lock;
+	GHashTable * objects;		/* GObject -> xTrackObject, while alive */
+	GPtrArray * elements;		/* xTrackElement */
+	volatile gint frames;		/* buffers that reached the video sink */
+	gint trace_base[2];			/* GstAllocTrace live counts at init */
+} xTrack;
+
+void xtrack_init(xTrack * track);
+void xtrack_attach(xTrack * track, GstElement * PipeLine);
+void xtrack_detach(xTrack * track);
+void xtrack_report(xTrack * track);
+void xtrack_release(xTrack * track);
+
+#endif /* XTRACK_H_ */